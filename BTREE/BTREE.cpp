@@ -2,18 +2,26 @@
 #include <vector>
 #include <random>
 #include <algorithm>
+#include <string>
+#include <sstream>
+#include <chrono>
+#include <cmath>
+#include <climits>
+#include <iomanip>
 
-//B-tree node structure for a 5-way B-tree (order 5)
+//B-tree node structure, 5-way (order 5) unless the tree says otherwise
 class BTreeNode {
 public:
-    std::vector<int> keys;          //Store keys (max 4 keys in a node)
-    std::vector<BTreeNode*> children; //Store child pointers (max 5 children)
+    std::vector<int> keys;          //Store keys (max order-1 keys in a node)
+    std::vector<BTreeNode*> children; //Store child pointers (max order children)
     bool isLeaf;
     
-    BTreeNode(bool leaf) {
+    BTreeNode(bool leaf, size_t maxKeys = 4) {
         isLeaf = leaf;
-        keys.reserve(4);      //Maximum 4 keys
-        children.reserve(5);  //Maximum 5 children
+        keys.reserve(maxKeys);           //Maximum order-1 keys
+        if (!leaf) {
+            children.reserve(maxKeys + 1); //Maximum order children
+        }
     }
     
     ~BTreeNode() {
@@ -27,27 +35,22 @@ public:
 class BTree {
 private:
     BTreeNode* root;
-    int t;
+    size_t maxKeys; //order - 1, 4 for the 5-way B-tree
+    
+    //Path from the root to the rightmost leaf, used by the append fast path
+    std::vector<BTreeNode*> rightSpine;
+    bool spineValid;
     
     //Helper to insert key in a non-full node
     void insertNonFull(BTreeNode* node, int key) {
-        int i = node->keys.size() - 1;
+        //Binary search for the first key greater than the new key
+        int i = std::upper_bound(node->keys.begin(), node->keys.end(), key) - node->keys.begin();
         
         if (node->isLeaf) {
             //Insert key in sorted position in leaf node
-            node->keys.push_back(0); // Add placeholder
-            while (i >= 0 && key < node->keys[i]) {
-                node->keys[i + 1] = node->keys[i];
-                i--;
-            }
-            node->keys[i + 1] = key;
+            node->keys.insert(node->keys.begin() + i, key);
         } else {
-            while (i >= 0 && key < node->keys[i]) {
-                i--;
-            }
-            i++;
-            
-            if (node->children[i]->keys.size() == 4) {
+            if (node->children[i]->keys.size() == maxKeys) {
                 splitChild(node, i, node->children[i]);
                 
 
@@ -61,55 +64,135 @@ private:
     
     //Helper to split a full child
     void splitChild(BTreeNode* parent, int i, BTreeNode* child) {
-        BTreeNode* newChild = new BTreeNode(child->isLeaf);
+        BTreeNode* newChild = new BTreeNode(child->isLeaf, maxKeys);
         
-        //Move the last (t-1) keys from child to newChild
-        for (int j = 0; j < 2; j++) {
-            newChild->keys.push_back(child->keys[j + 3]);
+        //Move the keys after the middle from child to newChild
+        for (size_t j = maxKeys / 2 + 1; j < maxKeys; j++) {
+            newChild->keys.push_back(child->keys[j]);
         }
         
-        //Move the last t children from child to newChild if not leaf
+        //Move the children after the middle from child to newChild if not leaf
         if (!child->isLeaf) {
-            for (int j = 0; j < 3; j++) {
-                newChild->children.push_back(child->children[j + 2]);
+            for (size_t j = maxKeys / 2 + 1; j <= maxKeys; j++) {
+                newChild->children.push_back(child->children[j]);
             }
-            child->children.resize(2);
+            child->children.resize(maxKeys / 2 + 1);
         }
         
-        child->keys.resize(2);
-        
         //Move middle key up to parent
-        int middleKey = child->keys[2];
-        child->keys.pop_back(); //Remove the middle from child
+        int middleKey = child->keys[maxKeys / 2];
+        child->keys.resize(maxKeys / 2); //Remove the middle and everything after it from child
         
         //Insert newChild into parent's children
         parent->children.insert(parent->children.begin() + i + 1, newChild);
         
         //Insert middle key into parent
         parent->keys.insert(parent->keys.begin() + i, middleKey);
+        
+        spineValid = false;
+    }
+    
+    //Rebuild the cached path from the root down to the rightmost leaf
+    void rebuildSpine() {
+        rightSpine.clear();
+        for (BTreeNode* node = root; node != nullptr;
+             node = node->isLeaf ? nullptr : node->children.back()) {
+            rightSpine.push_back(node);
+        }
+        spineValid = true;
+    }
+    
+    //Fast path for a key >= every key in the tree: append to the cached
+    //rightmost leaf without descending. A full node is split unevenly, the
+    //left node keeps maxKeys - 1 keys and only the last key moves over, so
+    //sequential loads leave nodes nearly full instead of half empty.
+    //Tradeoff: a late key that lands left of the spine finds one free slot,
+    //and the next one splits that node in the middle. The nearly-sorted
+    //benchmark measures this; at orders 16/64 occupancy drops from 0.93/0.98
+    //(sequential) to 0.67/0.54. An even split gives 0.47-0.52 on both, and
+    //splitting evenly only nodes that already took a late key never did better.
+    void appendRightmost(int key) {
+        int level = rightSpine.size() - 1;
+        BTreeNode* leaf = rightSpine[level];
+        
+        if (leaf->keys.size() < maxKeys) {
+            leaf->keys.push_back(key);
+            return;
+        }
+        
+        //Leaf is full: its last key becomes the separator, new key starts a new leaf
+        int separator = leaf->keys.back();
+        leaf->keys.pop_back();
+        BTreeNode* newNode = new BTreeNode(true, maxKeys);
+        newNode->keys.push_back(key);
+        rightSpine[level] = newNode;
+        
+        //Push the separator up the right spine, splitting full parents the same way
+        while (level > 0) {
+            level--;
+            BTreeNode* parent = rightSpine[level];
+            
+            if (parent->keys.size() < maxKeys) {
+                parent->keys.push_back(separator);
+                parent->children.push_back(newNode);
+                return;
+            }
+            
+            BTreeNode* newParent = new BTreeNode(false, maxKeys);
+            newParent->keys.push_back(separator);
+            newParent->children.push_back(parent->children.back());
+            newParent->children.push_back(newNode);
+            parent->children.pop_back();
+            
+            separator = parent->keys.back();
+            parent->keys.pop_back();
+            
+            newNode = newParent;
+            rightSpine[level] = newNode;
+        }
+        
+        //Root was split
+        BTreeNode* newRoot = new BTreeNode(false, maxKeys);
+        newRoot->keys.push_back(separator);
+        newRoot->children.push_back(root);
+        newRoot->children.push_back(newNode);
+        root = newRoot;
+        rightSpine.insert(rightSpine.begin(), newRoot);
+    }
+    
+    //Helper to count nodes, keys and heap bytes for statistics
+    void countHelper(BTreeNode* node, long long& nodes, long long& keys, long long& bytes) {
+        if (node == nullptr) return;
+        
+        nodes++;
+        keys += node->keys.size();
+        bytes += sizeof(BTreeNode) + node->keys.capacity() * sizeof(int)
+               + node->children.capacity() * sizeof(BTreeNode*);
+        for (auto child : node->children) {
+            countHelper(child, nodes, keys, bytes);
+        }
     }
     
     // Helper for range search
     void rangeSearchHelper(BTreeNode* node, int low, int high, std::vector<int>& result) {
         if (node == nullptr) return;
         
-        int i = 0;
-        //Traverse through all keys and children
-        while (i < node->keys.size()) {
+        //Skip keys (and the subtrees left of them) that are below the range
+        size_t i = std::lower_bound(node->keys.begin(), node->keys.end(), low) - node->keys.begin();
+        //Traverse keys and children until past the end of the range
+        while (i < node->keys.size() && node->keys[i] <= high) {
             //If not leaf, then traverse the subtree rooted with child[i]
             if (!node->isLeaf) {
                 rangeSearchHelper(node->children[i], low, high, result);
             }
             
-            //If current key is in range, add to result
-            if (node->keys[i] >= low && node->keys[i] <= high) {
-                result.push_back(node->keys[i]);
-            }
+            //Current key is in range, add to result
+            result.push_back(node->keys[i]);
             
             i++;
         }
         
-        //Traverse the subtree rooted with last child
+        //Traverse the subtree rooted with the child right of the last visited key
         if (!node->isLeaf) {
             rangeSearchHelper(node->children[i], low, high, result);
         }
@@ -133,9 +216,10 @@ private:
     }
     
 public:
-    BTree() {
+    BTree(int order = 5) {
         root = nullptr;
-        t = 2;  //For 5-way B-tree (2*t-1 = 3 max keys, but will allow 4)
+        maxKeys = static_cast<size_t>(std::max(order, 4) - 1); //Splitting needs at least 3 keys per node
+        spineValid = false;
     }
     
     ~BTree() {
@@ -145,12 +229,23 @@ public:
     //Insert a key into the B-tree
     void insert(int key) {
         if (root == nullptr) {
-            root = new BTreeNode(true);
+            root = new BTreeNode(true, maxKeys);
             root->keys.push_back(key);
+            spineValid = false;
         } else {
+            if (!spineValid) {
+                rebuildSpine();
+            }
+            
+            //Keys arriving in ascending order (e.g. timestamps) skip the descent
+            if (key >= rightSpine.back()->keys.back()) {
+                appendRightmost(key);
+                return;
+            }
+            
             //If root is full, split it
-            if (root->keys.size() == 4) {
-                BTreeNode* newRoot = new BTreeNode(false);
+            if (root->keys.size() == maxKeys) {
+                BTreeNode* newRoot = new BTreeNode(false, maxKeys);
                 newRoot->children.push_back(root);
                 splitChild(newRoot, 0, root);
                 
@@ -168,6 +263,19 @@ public:
         }
     }
     
+    //Search for a single key
+    bool search(int key) {
+        BTreeNode* node = root;
+        while (node != nullptr) {
+            auto it = std::lower_bound(node->keys.begin(), node->keys.end(), key);
+            if (it != node->keys.end() && *it == key) {
+                return true;
+            }
+            node = node->isLeaf ? nullptr : node->children[it - node->keys.begin()];
+        }
+        return false;
+    }
+    
     //Search for keys in range [low, high]
     std::vector<int> rangeSearch(int low, int high) {
         std::vector<int> result;
@@ -185,6 +293,30 @@ public:
         }
     }
     
+    //Fraction of key slots in use across all nodes
+    double occupancy() {
+        long long nodes = 0, keys = 0, bytes = 0;
+        countHelper(root, nodes, keys, bytes);
+        return nodes == 0 ? 0.0 : static_cast<double>(keys) / (nodes * maxKeys);
+    }
+    
+    //Heap bytes used by all nodes divided by the number of keys stored
+    double bytesPerKey() {
+        long long nodes = 0, keys = 0, bytes = 0;
+        countHelper(root, nodes, keys, bytes);
+        return keys == 0 ? 0.0 : static_cast<double>(bytes) / keys;
+    }
+    
+    //Number of levels (0 for an empty tree)
+    int height() {
+        int levels = 0;
+        for (BTreeNode* node = root; node != nullptr;
+             node = node->isLeaf ? nullptr : node->children.front()) {
+            levels++;
+        }
+        return levels;
+    }
+    
     // Get the root node
     BTreeNode* getRoot() {
         return root;
@@ -207,7 +339,273 @@ std::vector<int> generateRandomKeys(int N) {
     return keys;
 }
 
-int main() {
+// ===================== BENCHMARK MODE =====================
+// Run as: BTREE.exe --bench [--sizes 1000,1000000] [--orders 5,16,64]
+//         [--dists uniform,zipf,sequential,nearly-sorted,clustered] [--queries Q] [--seed S]
+// Prints one JSON document to stdout.
+
+//Zipf(s) sampler over ranks [1, n] by rejection-inversion (Hormann & Derflinger),
+//constant time per sample so it works for universes of billions of keys
+class ZipfGenerator {
+private:
+    double s, hIntegralX1, hIntegralN, sVal;
+    long long n;
+    
+    double h(double x) { return std::exp(-s * std::log(x)); }
+    double hIntegral(double x) {
+        double logX = std::log(x);
+        return helper2((1.0 - s) * logX) * logX;
+    }
+    double hIntegralInverse(double x) {
+        double t = std::max(x * (1.0 - s), -1.0);
+        return std::exp(helper1(t) * x);
+    }
+    //log1p(x)/x and expm1(x)/x, stable near 0
+    static double helper1(double x) { return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x / 2.0; }
+    static double helper2(double x) { return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x / 2.0; }
+    
+public:
+    ZipfGenerator(long long n, double s) : s(s), n(n) {
+        hIntegralX1 = hIntegral(1.5) - 1.0;
+        hIntegralN = hIntegral(n + 0.5);
+        sVal = 2.0 - hIntegralInverse(hIntegral(2.5) - h(2.0));
+    }
+    
+    long long operator()(std::mt19937_64& gen) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        while (true) {
+            double u = hIntegralN + dist(gen) * (hIntegralX1 - hIntegralN);
+            double x = hIntegralInverse(u);
+            long long k = static_cast<long long>(x + 0.5);
+            k = std::min(std::max(k, 1LL), n);
+            if (k - x <= sVal || u >= hIntegral(k + 0.5) - h(static_cast<double>(k))) {
+                return k;
+            }
+        }
+    }
+};
+
+//Keys for one benchmark distribution, drawn from [0, min(3N, INT_MAX)]
+std::vector<int> generateBenchKeys(const std::string& distName, int N, unsigned seed) {
+    long long universe = std::min(3LL * N, (long long)INT_MAX);
+    std::vector<int> keys;
+    keys.reserve(N);
+    std::mt19937_64 gen(seed);
+    
+    if (distName == "sequential") {
+        //Ascending timestamps with small random gaps
+        long long key = 0;
+        for (int i = 0; i < N; i++) {
+            keys.push_back(static_cast<int>(key));
+            key = std::min(key + 1 + static_cast<long long>(gen() % 3), universe);
+        }
+    } else if (distName == "nearly-sorted") {
+        //Ascending timestamps, but one key in ten arrives late (up to 1000 below the newest)
+        long long key = 0;
+        for (int i = 0; i < N; i++) {
+            long long late = (gen() % 10 == 0) ? static_cast<long long>(gen() % 1000) : 0;
+            keys.push_back(static_cast<int>(std::max(0LL, key - late)));
+            key = std::min(key + 1 + static_cast<long long>(gen() % 3), universe);
+        }
+    } else if (distName == "zipf") {
+        //Popular ranks are scattered over the key space by a multiplicative hash
+        ZipfGenerator zipf(universe, 0.99);
+        for (int i = 0; i < N; i++) {
+            unsigned long long rank = zipf(gen);
+            keys.push_back(static_cast<int>((rank * 0x9E3779B97F4A7C15ULL >> 11) % (universe + 1)));
+        }
+    } else if (distName == "clustered") {
+        //Dense runs of 1000 keys around a random set of cluster centers
+        int clusters = std::max(1, N / 1000);
+        std::vector<long long> centers(clusters);
+        for (auto& c : centers) {
+            c = gen() % (universe + 1);
+        }
+        for (int i = 0; i < N; i++) {
+            long long key = centers[gen() % clusters] + static_cast<long long>(gen() % 1000);
+            keys.push_back(static_cast<int>(std::min(key, universe)));
+        }
+    } else {
+        std::uniform_int_distribution<long long> dist(0, universe);
+        for (int i = 0; i < N; i++) {
+            keys.push_back(static_cast<int>(dist(gen)));
+        }
+    }
+    
+    return keys;
+}
+
+//Comma-separated list helper for the command-line options
+std::vector<std::string> splitList(const std::string& str) {
+    std::vector<std::string> items;
+    std::stringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        if (!item.empty()) {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+struct LatencyStats {
+    double opsPerSec;
+    double p50Ns;
+    double p99Ns;
+};
+
+//Runs op(i) for i in [0, count). Every op counts toward throughput; at most
+//about a million of them are individually timed for the percentiles.
+template <typename Op>
+LatencyStats measure(long long count, Op op) {
+    typedef std::chrono::steady_clock Clock;
+    long long sampleEvery = std::max(1LL, count / 1000000);
+    std::vector<double> samples;
+    samples.reserve(count / sampleEvery + 1);
+    
+    auto start = Clock::now();
+    for (long long i = 0; i < count; i++) {
+        if (i % sampleEvery == 0) {
+            auto t0 = Clock::now();
+            op(i);
+            samples.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+        } else {
+            op(i);
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    
+    LatencyStats stats = {0.0, 0.0, 0.0};
+    if (count == 0) return stats;
+    stats.opsPerSec = seconds > 0 ? count / seconds : 0.0;
+    std::sort(samples.begin(), samples.end());
+    stats.p50Ns = samples[samples.size() / 2];
+    stats.p99Ns = samples[std::min(samples.size() - 1, samples.size() * 99 / 100)];
+    return stats;
+}
+
+void printStatsJson(const char* name, const LatencyStats& stats) {
+    std::cout << "\"" << name << "\": {\"ops_per_sec\": " << stats.opsPerSec
+              << ", \"p50_ns\": " << stats.p50Ns << ", \"p99_ns\": " << stats.p99Ns << "}";
+}
+
+//Range accepted by --orders: BTree raises smaller orders to 4 (splitting needs
+//at least 3 keys per node), and every node reserves order - 1 key slots
+const int MIN_BENCH_ORDER = 4;
+const int MAX_BENCH_ORDER = 1 << 16;
+
+int runBenchmark(int argc, char* argv[]) {
+    std::vector<std::string> sizes = {"1000", "10000", "100000", "1000000"};
+    std::vector<std::string> orders = {"5", "16", "64", "256"};
+    std::vector<std::string> dists = {"uniform", "zipf", "sequential", "nearly-sorted", "clustered"};
+    long long queries = 100000;
+    unsigned seed = 42;
+    
+    //Everything is parsed and range-checked before any keys are generated
+    std::vector<int> sizeValues, orderValues;
+    try {
+        for (int a = 2; a + 1 < argc; a += 2) {
+            std::string opt = argv[a];
+            std::string val = argv[a + 1];
+            if (opt == "--sizes") sizes = splitList(val);
+            else if (opt == "--orders") orders = splitList(val);
+            else if (opt == "--dists") dists = splitList(val);
+            else if (opt == "--queries") queries = std::stoll(val);
+            else if (opt == "--seed") seed = static_cast<unsigned>(std::stoul(val));
+            else {
+                std::cerr << "Unknown option " << opt << std::endl;
+                return 1;
+            }
+        }
+        
+        if (queries <= 0 || queries > INT_MAX) {
+            std::cerr << "Error: --queries must be in [1, " << INT_MAX << "]" << std::endl;
+            return 1;
+        }
+        for (const auto& sizeStr : sizes) {
+            double value = std::stod(sizeStr); //accepts 1e9 as well as 1000000000
+            if (!(value >= 1 && value <= INT_MAX)) {
+                std::cerr << "Error: size " << sizeStr << " must be in [1, " << INT_MAX << "]" << std::endl;
+                return 1;
+            }
+            sizeValues.push_back(static_cast<int>(value));
+        }
+        for (const auto& orderStr : orders) {
+            long long value = std::stoll(orderStr);
+            if (value < MIN_BENCH_ORDER || value > MAX_BENCH_ORDER) {
+                std::cerr << "Error: order " << orderStr << " must be in [" << MIN_BENCH_ORDER << ", "
+                          << MAX_BENCH_ORDER << "]" << std::endl;
+                return 1;
+            }
+            orderValues.push_back(static_cast<int>(value));
+        }
+    } catch (const std::exception&) {
+        std::cerr << "Error: option values must be numbers" << std::endl;
+        return 1;
+    }
+    
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "{\"seed\": " << seed << ", \"queries\": " << queries << ", \"results\": [";
+    bool first = true;
+    
+    for (int N : sizeValues) {
+        for (const auto& distName : dists) {
+            std::vector<int> keys = generateBenchKeys(distName, N, seed);
+            long long universe = std::min(3LL * N, (long long)INT_MAX);
+            
+            //Queries are generated up front so RNG cost stays out of the timings
+            std::mt19937_64 gen(seed + 1);
+            std::vector<int> probes(queries);
+            for (auto& p : probes) {
+                //Half hits (existing keys), half uniform over the key space
+                p = (gen() & 1) ? keys[gen() % N] : static_cast<int>(gen() % (universe + 1));
+            }
+            //Range width chosen to cover about 100 keys on average
+            long long width = std::max(1LL, universe * 100 / N);
+            
+            for (int order : orderValues) {
+                BTree tree(order);
+                
+                LatencyStats insertStats = measure(N, [&](long long i) { tree.insert(keys[i]); });
+                
+                long long found = 0;
+                LatencyStats searchStats = measure(queries, [&](long long i) { found += tree.search(probes[i]); });
+                
+                long long rangeQueries = std::max(1LL, queries / 10);
+                long long rangeKeys = 0;
+                LatencyStats rangeStats = measure(rangeQueries, [&](long long i) {
+                    int low = probes[i];
+                    int high = static_cast<int>(std::min((long long)low + width, (long long)INT_MAX));
+                    rangeKeys += tree.rangeSearch(low, high).size();
+                });
+                
+                std::cout << (first ? "" : ",") << "\n  {\"n\": " << N << ", \"dist\": \"" << distName
+                          << "\", \"order\": " << order << ", ";
+                printStatsJson("insert", insertStats);
+                std::cout << ", ";
+                printStatsJson("search", searchStats);
+                std::cout << ", ";
+                printStatsJson("range", rangeStats);
+                std::cout << ", \"search_hits\": " << found
+                          << ", \"range_keys_avg\": " << static_cast<double>(rangeKeys) / rangeQueries
+                          << ", \"bytes_per_key\": " << tree.bytesPerKey()
+                          << ", \"occupancy\": " << tree.occupancy()
+                          << ", \"height\": " << tree.height() << "}";
+                std::cout.flush();
+                first = false;
+            }
+        }
+    }
+    
+    std::cout << "\n]}" << std::endl;
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    if (argc > 1 && std::string(argv[1]) == "--bench") {
+        return runBenchmark(argc, argv);
+    }
+    
     int N;
     
     //Get input N from user
@@ -254,6 +652,7 @@ int main() {
     std::cout << "Keys found in range [" << N << ", " << 2*N << "]: " << foundKeys.size() << std::endl;
     std::cout << "Percentage of keys in range: " 
               << (static_cast<double>(foundKeys.size()) / N * 100) << "%" << std::endl;
+    std::cout << "Node occupancy: " << (tree.occupancy() * 100) << "%" << std::endl;
     
     return 0;
 }
\ No newline at end of file
@@ -1,40 +1,747 @@
 #include <iostream>
 #include <vector>
-#include <list>
 #include <algorithm>
 #include <random>
-#include <set>
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cmath>
+#include <climits>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <sstream>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
 
-class HashTable {
+// SSE2 group probing on x86/x64, plain byte loop everywhere else
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define HASH_USE_SSE2
+#endif
+
+// Default hash: murmur3 finalizer, spreads nearby keys over all 64 bits so
+// the control byte (low 7 bits), the probe start (the bits above it) and the
+// radix partition (top bits) all see well mixed input
+struct IntHash {
+    size_t operator()(int key) const {
+        uint64_t h = static_cast<uint32_t>(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdULL;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ULL;
+        h ^= h >> 33;
+        return static_cast<size_t>(h);
+    }
+};
+
+// ===================== RADIX PARTITIONING =====================
+// Input split into 2^bits partitions by the top bits of its hash, each stored
+// contiguously: partition p is values[offsets[p] .. offsets[p + 1]).
+struct RadixPartitions {
+    std::vector<int> values;
+    std::vector<size_t> offsets;
+};
+
+// Runs fn(t) on threads t = 0..threads-1 and waits for all of them
+template <typename Fn>
+void parallelFor(int threads, Fn fn) {
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(fn, t);
+    }
+    fn(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Two passes over the input: every thread builds a histogram of its chunk,
+// the prefix sums give each (partition, thread) pair a private output range,
+// then every thread scatters its chunk there. No locks, no per-value allocation.
+template <typename Hash>
+RadixPartitions radixPartition(const int* data, size_t count, int bits, const Hash& hasher, int threads) {
+    const size_t partitions = size_t(1) << bits;
+    const int shift = static_cast<int>(sizeof(size_t) * 8) - bits;
+    threads = static_cast<int>(std::max<size_t>(1, std::min<size_t>(threads, count / 4096 + 1)));
+    
+    std::vector<std::vector<size_t>> histograms(threads, std::vector<size_t>(partitions, 0));
+    auto chunkBegin = [&](int t) { return count * t / threads; };
+    
+    parallelFor(threads, [&](int t) {
+        std::vector<size_t>& histogram = histograms[t];
+        for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); i++) {
+            histogram[static_cast<size_t>(hasher(data[i])) >> shift]++;
+        }
+    });
+    
+    // Turn counts into write positions, partition-major so partitions are contiguous
+    RadixPartitions result;
+    result.offsets.assign(partitions + 1, 0);
+    size_t position = 0;
+    for (size_t p = 0; p < partitions; p++) {
+        result.offsets[p] = position;
+        for (int t = 0; t < threads; t++) {
+            size_t n = histograms[t][p];
+            histograms[t][p] = position;
+            position += n;
+        }
+    }
+    result.offsets[partitions] = position;
+    
+    result.values.resize(count);
+    parallelFor(threads, [&](int t) {
+        std::vector<size_t>& cursor = histograms[t];
+        int* out = result.values.data();
+        for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); i++) {
+            out[cursor[static_cast<size_t>(hasher(data[i])) >> shift]++] = data[i];
+        }
+    });
+    
+    return result;
+}
+
+// ===================== INSTRUMENTATION =====================
+// Probe-length histograms, resize counts and sampled latencies for the tables.
+// Off by default: every counted lookup writes the table's counters, so readers
+// sharing a ConcurrentHashTable shard would contend on those cache lines.
+// Build with /DHASH_TABLE_STATS=1 to compile the hooks in.
+#ifndef HASH_TABLE_STATS
+#define HASH_TABLE_STATS 0
+#endif
+
+const int STATS_PROBE_BUCKETS = 16;    // groups visited per operation, last bucket is 16+
+const int STATS_LATENCY_BUCKETS = 32;  // power-of-two nanosecond buckets
+const int STATS_SAMPLE_EVERY = 1024;   // time one operation in this many
+
+// Counter that concurrent readers can bump under a shared lock: a relaxed
+// load and store, so an increment may be lost under contention but never tears
+class StatCounter {
 private:
-    static const int TABLE_SIZE = 10; // 10 possible first digits (0-9)
-    std::vector<std::list<int>> table;
+    std::atomic<uint64_t> value;
     
-    // Hash function
-    int hashFunction(int key) {
-        return key / 10;
+public:
+    StatCounter() : value(0) {}
+    StatCounter(const StatCounter& other) : value(other.get()) {}
+    StatCounter& operator=(const StatCounter& other) {
+        value.store(other.get(), std::memory_order_relaxed);
+        return *this;
+    }
+    
+    void add(uint64_t n = 1) {
+        value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
     }
     
+    uint64_t get() const {
+        return value.load(std::memory_order_relaxed);
+    }
+};
+
+// Live counters kept inside a table
+struct StatCounters {
+    StatCounter inserts, lookups, erases;
+    StatCounter growResizes, inPlaceRehashes;
+    StatCounter insertProbes[STATS_PROBE_BUCKETS];
+    StatCounter lookupProbes[STATS_PROBE_BUCKETS];
+    StatCounter insertLatency[STATS_LATENCY_BUCKETS];
+    StatCounter lookupLatency[STATS_LATENCY_BUCKETS];
+};
+
+// Times the enclosing operation when opIndex is a multiple of STATS_SAMPLE_EVERY
+class LatencySample {
+private:
+    StatCounter* histogram;
+    std::chrono::steady_clock::time_point start;
+    
 public:
-    HashTable() : table(TABLE_SIZE) {}
+    LatencySample(StatCounter* buckets, uint64_t opIndex)
+        : histogram(opIndex % STATS_SAMPLE_EVERY == 0 ? buckets : nullptr) {
+        if (histogram) start = std::chrono::steady_clock::now();
+    }
     
-    // Insert a value into the hash table
-    void insert(int value) {
-        int index = hashFunction(value);
-        table[index].push_back(value);
+    ~LatencySample() {
+        if (!histogram) return;
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        int bucket = 0;
+        while (bucket + 1 < STATS_LATENCY_BUCKETS && (1LL << (bucket + 1)) <= ns) {
+            bucket++;
+        }
+        histogram[bucket].add();
     }
+};
+
+// Plain snapshot returned by stats()
+struct HashTableStats {
+    uint64_t size = 0, capacity = 0, tombstones = 0;
+    uint64_t inserts = 0, lookups = 0, erases = 0;
+    uint64_t growResizes = 0, inPlaceRehashes = 0;
+    uint64_t insertProbes[STATS_PROBE_BUCKETS] = {};
+    uint64_t lookupProbes[STATS_PROBE_BUCKETS] = {};
+    uint64_t insertLatency[STATS_LATENCY_BUCKETS] = {};  // bucket b: [2^b, 2^(b+1)) ns
+    uint64_t lookupLatency[STATS_LATENCY_BUCKETS] = {};
     
-    // Remove duplicates from all chains
-    void removeDuplicates() {
-        for (int i = 0; i < TABLE_SIZE; i++) {
-            if (!table[i].empty()) {
-                // Use a set to find unique values
-                std::set<int> uniqueValues(table[i].begin(), table[i].end());
-                table[i].assign(uniqueValues.begin(), uniqueValues.end());
+    double loadFactor() const {
+        return capacity == 0 ? 0.0 : static_cast<double>(size) / capacity;
+    }
+    
+    static double meanProbe(const uint64_t* histogram) {
+        uint64_t count = 0, sum = 0;
+        for (int i = 0; i < STATS_PROBE_BUCKETS; i++) {
+            count += histogram[i];
+            sum += histogram[i] * (i + 1);
+        }
+        return count == 0 ? 0.0 : static_cast<double>(sum) / count;
+    }
+    
+    // Upper bound (ns) of the bucket holding the given quantile of samples
+    static uint64_t latencyQuantile(const uint64_t* histogram, double q) {
+        uint64_t count = 0;
+        for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) count += histogram[i];
+        if (count == 0) return 0;
+        uint64_t target = static_cast<uint64_t>(q * (count - 1)), seen = 0;
+        for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+            seen += histogram[i];
+            if (seen > target) return uint64_t(1) << (i + 1);
+        }
+        return uint64_t(1) << STATS_LATENCY_BUCKETS;
+    }
+    
+    void add(const HashTableStats& other) {
+        size += other.size;
+        capacity += other.capacity;
+        tombstones += other.tombstones;
+        inserts += other.inserts;
+        lookups += other.lookups;
+        erases += other.erases;
+        growResizes += other.growResizes;
+        inPlaceRehashes += other.inPlaceRehashes;
+        for (int i = 0; i < STATS_PROBE_BUCKETS; i++) {
+            insertProbes[i] += other.insertProbes[i];
+            lookupProbes[i] += other.lookupProbes[i];
+        }
+        for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+            insertLatency[i] += other.insertLatency[i];
+            lookupLatency[i] += other.lookupLatency[i];
+        }
+    }
+    
+    std::string toJson() const {
+        std::ostringstream out;
+        auto list = [&out](const uint64_t* values, int n) {
+            out << "[";
+            for (int i = 0; i < n; i++) out << (i ? ", " : "") << values[i];
+            out << "]";
+        };
+        out << "{\"size\": " << size << ", \"capacity\": " << capacity << ", \"tombstones\": " << tombstones
+            << ", \"load_factor\": " << loadFactor()
+            << ", \"inserts\": " << inserts << ", \"lookups\": " << lookups << ", \"erases\": " << erases
+            << ", \"grow_resizes\": " << growResizes << ", \"in_place_rehashes\": " << inPlaceRehashes
+            << ", \"mean_insert_probe\": " << meanProbe(insertProbes)
+            << ", \"mean_lookup_probe\": " << meanProbe(lookupProbes)
+            << ", \"insert_probe_histogram\": ";
+        list(insertProbes, STATS_PROBE_BUCKETS);
+        out << ", \"lookup_probe_histogram\": ";
+        list(lookupProbes, STATS_PROBE_BUCKETS);
+        out << ", \"insert_latency_p50_ns\": " << latencyQuantile(insertLatency, 0.5)
+            << ", \"insert_latency_p99_ns\": " << latencyQuantile(insertLatency, 0.99)
+            << ", \"lookup_latency_p50_ns\": " << latencyQuantile(lookupLatency, 0.5)
+            << ", \"lookup_latency_p99_ns\": " << latencyQuantile(lookupLatency, 0.99) << "}";
+        return out.str();
+    }
+};
+
+// Open-addressing hash table in the Swiss-table style. Every slot has a one
+// byte control tag (empty, deleted, or the low 7 bits of the hash), and slots
+// are probed 16 at a time by comparing a whole group of tags at once.
+// Each distinct key is stored once with a count, so inserting a duplicate
+// only bumps the count and never allocates.
+template <typename Hash = IntHash>
+class BasicHashTable {
+private:
+    static const int TABLE_SIZE = 10; // 10 possible first digits (0-9) in the bucket view
+    static const int GROUP_WIDTH = 16;
+    static const signed char CTRL_EMPTY = -128;  // 0b10000000
+    static const signed char CTRL_DELETED = -2;  // 0b11111110, full slots are 0..127
+    
+    struct Slot {
+        int key;
+        int count;
+    };
+    
+    std::vector<signed char> ctrl;
+    std::vector<Slot> slots;
+    size_t size_ = 0;       // distinct keys stored
+    size_t tombstones = 0;  // deleted slots not yet reclaimed
+    double maxLoadFactor = 0.875;
+    bool dedupeOnInsert = false;  // reject duplicates instead of counting them
+    Hash hasher;
+#if HASH_TABLE_STATS
+    mutable StatCounters counters;
+#endif
+    
+    // Bitmask of the positions in a group whose tag equals h2
+    static unsigned matchTag(const signed char* group, signed char h2) {
+#ifdef HASH_USE_SSE2
+        __m128i tags = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(tags, _mm_set1_epi8(h2)));
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < GROUP_WIDTH; i++) {
+            if (group[i] == h2) mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+    
+    // Bitmask of the empty or deleted positions in a group (sign bit set)
+    static unsigned matchEmptyOrDeleted(const signed char* group) {
+#ifdef HASH_USE_SSE2
+        return _mm_movemask_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(group)));
+#else
+        unsigned mask = 0;
+        for (int i = 0; i < GROUP_WIDTH; i++) {
+            if (group[i] < 0) mask |= 1u << i;
+        }
+        return mask;
+#endif
+    }
+    
+    static unsigned matchEmpty(const signed char* group) {
+        return matchTag(group, CTRL_EMPTY);
+    }
+    
+    static int lowestBit(unsigned mask) {
+        int i = 0;
+        while (!(mask & 1u)) {
+            mask >>= 1;
+            i++;
+        }
+        return i;
+    }
+    
+    size_t groupMask() const {
+        return ctrl.size() / GROUP_WIDTH - 1;
+    }
+    
+    // Slot index of key, or -1 if absent. Groups are visited in
+    // triangular order, which reaches every group of a power-of-two table.
+    long long findIndex(int key, size_t hash) const {
+        size_t groupsVisited;
+        return findIndex(key, hash, groupsVisited);
+    }
+    
+    // Same, also reporting how many groups the probe visited
+    long long findIndex(int key, size_t hash, size_t& groupsVisited) const {
+        groupsVisited = 0;
+        if (size_ == 0) return -1;
+        signed char h2 = static_cast<signed char>(hash & 0x7F);
+        size_t mask = groupMask();
+        size_t group = (hash >> 7) & mask;
+        
+        for (size_t step = 1; ; step++) {
+            groupsVisited = step;
+            const signed char* tags = &ctrl[group * GROUP_WIDTH];
+            for (unsigned match = matchTag(tags, h2); match; match &= match - 1) {
+                size_t index = group * GROUP_WIDTH + lowestBit(match);
+                if (slots[index].key == key) return static_cast<long long>(index);
             }
+            // An empty slot ends the probe sequence
+            if (matchEmpty(tags)) return -1;
+            group = (group + step) & mask;
         }
     }
     
+#if HASH_TABLE_STATS
+    static void recordProbe(StatCounter* histogram, size_t groupsVisited) {
+        histogram[std::min<size_t>(std::max<size_t>(groupsVisited, 1), STATS_PROBE_BUCKETS) - 1].add();
+    }
+#endif
+    
+    // First empty or deleted slot on the probe sequence of hash
+    size_t findInsertSlot(size_t hash) const {
+        size_t mask = groupMask();
+        size_t group = (hash >> 7) & mask;
+        
+        for (size_t step = 1; ; step++) {
+            unsigned free = matchEmptyOrDeleted(&ctrl[group * GROUP_WIDTH]);
+            if (free) return group * GROUP_WIDTH + lowestBit(free);
+            group = (group + step) & mask;
+        }
+    }
+    
+    // Add an entry during bulkBuild: merge it with an equal key or take the
+    // first free slot on its probe sequence. Returns 1 if it took a new slot,
+    // 0 if it was merged, or -1 if the probe would leave region r of the
+    // table, the groups [r << regionShift, (r + 1) << regionShift).
+    int bulkPlace(const Slot& entry, size_t r, int regionShift) {
+        size_t hash = hasher(entry.key);
+        signed char h2 = static_cast<signed char>(hash & 0x7F);
+        size_t mask = groupMask();
+        size_t group = (hash >> 7) & mask;
+        
+        for (size_t step = 1; ; step++) {
+            signed char* tags = &ctrl[group * GROUP_WIDTH];
+            for (unsigned match = matchTag(tags, h2); match; match &= match - 1) {
+                Slot& slot = slots[group * GROUP_WIDTH + lowestBit(match)];
+                if (slot.key == entry.key) {
+                    if (!dedupeOnInsert) slot.count += entry.count;
+                    return 0;
+                }
+            }
+            unsigned empty = matchEmpty(tags);
+            if (empty) {
+                size_t index = group * GROUP_WIDTH + lowestBit(empty);
+                ctrl[index] = h2;
+                slots[index].key = entry.key;
+                slots[index].count = dedupeOnInsert ? 1 : entry.count;
+                return 1;
+            }
+            group = (group + step) & mask;
+            if ((group >> regionShift) != r) return -1;
+        }
+    }
+    
+    void rehash(size_t newCapacity) {
+#if HASH_TABLE_STATS
+        if (newCapacity > ctrl.size()) counters.growResizes.add();
+        else counters.inPlaceRehashes.add();
+#endif
+        std::vector<signed char> oldCtrl;
+        std::vector<Slot> oldSlots;
+        oldCtrl.swap(ctrl);
+        oldSlots.swap(slots);
+        
+        ctrl.assign(newCapacity, static_cast<signed char>(CTRL_EMPTY));
+        slots.resize(newCapacity);
+        tombstones = 0;
+        
+        for (size_t i = 0; i < oldCtrl.size(); i++) {
+            if (oldCtrl[i] >= 0) {
+                size_t hash = hasher(oldSlots[i].key);
+                size_t index = findInsertSlot(hash);
+                ctrl[index] = static_cast<signed char>(hash & 0x7F);
+                slots[index] = oldSlots[i];
+            }
+        }
+    }
+    
+    // Make room for one more key: double when full of live keys,
+    // rehash in place when most of the load is tombstones
+    void reserveOne() {
+        size_t capacity = ctrl.size();
+        if (capacity == 0) {
+            rehash(GROUP_WIDTH);
+            return;
+        }
+        if (size_ + tombstones + 1 > capacity * maxLoadFactor) {
+            rehash(size_ + 1 > capacity * maxLoadFactor / 2 ? capacity * 2 : capacity);
+        }
+    }
+    
+    // Leading decimal digit, used to group keys in the bucket view
+    int hashFunction(int key) const {
+        long long value = key < 0 ? -static_cast<long long>(key) : key;
+        while (value >= 10) {
+            value /= 10;
+        }
+        return static_cast<int>(value);
+    }
+    
+public:
+    BasicHashTable(const Hash& hash = Hash()) : hasher(hash) {}
+    
+    // Insert a value into the hash table. Returns true if the value was new;
+    // a duplicate raises its count, or is rejected in dedupe-on-insert mode.
+    bool insert(int value) {
+        return insertCount(value, 1);
+    }
+    
+    // Insert count copies of value at once
+    bool insertCount(int value, int count) {
+#if HASH_TABLE_STATS
+        LatencySample sample(counters.insertLatency, counters.inserts.get());
+        counters.inserts.add();
+#endif
+        size_t hash = hasher(value);
+        size_t groupsVisited;
+        long long index = findIndex(value, hash, groupsVisited);
+#if HASH_TABLE_STATS
+        recordProbe(counters.insertProbes, groupsVisited);
+#endif
+        if (index >= 0) {
+            if (!dedupeOnInsert) slots[index].count += count;
+            return false;
+        }
+        
+        reserveOne();
+        size_t slot = findInsertSlot(hash);
+        if (ctrl[slot] == CTRL_DELETED) tombstones--;
+        ctrl[slot] = static_cast<signed char>(hash & 0x7F);
+        slots[slot].key = value;
+        slots[slot].count = dedupeOnInsert ? 1 : count;
+        size_++;
+        return true;
+    }
+    
+    // Grow once so that n distinct keys fit without further rehashing
+    void reserve(size_t n) {
+        size_t capacity = GROUP_WIDTH;
+        while (n > capacity * maxLoadFactor) {
+            capacity *= 2;
+        }
+        if (capacity > ctrl.size()) {
+            rehash(capacity);
+        }
+    }
+    
+    // Load a whole batch: radix-partition it in parallel by hash bits, count
+    // and deduplicate every partition independently on the worker threads,
+    // then rebuild the slot array region by region. The distinct keys and the
+    // keys already stored are regrouped by the region their probe starts in,
+    // so every worker writes only the groups of the regions it owns.
+    void bulkBuild(const int* data, size_t count, int threads = defaultThreadCount()) {
+        const int bits = 8;
+        RadixPartitions parts = radixPartition(data, count, bits, hasher, threads);
+        const size_t partitions = size_t(1) << bits;
+        
+        // Sources of the rebuild: the distinct keys of every partition,
+        // followed by one chunk of the current contents per thread
+        std::vector<std::vector<Slot>> sources(partitions + threads);
+        std::atomic<size_t> nextPartition(0);
+        parallelFor(threads, [&](int t) {
+            BasicHashTable<Hash> local(hasher);
+            for (size_t p = nextPartition++; p < partitions; p = nextPartition++) {
+                local.clear();
+                local.reserve(parts.offsets[p + 1] - parts.offsets[p]);
+                for (size_t i = parts.offsets[p]; i < parts.offsets[p + 1]; i++) {
+                    local.insert(parts.values[i]);
+                }
+                sources[p].reserve(local.size());
+                local.forEach([&](int key, int n) { sources[p].push_back({key, n}); });
+            }
+            for (size_t i = ctrl.size() * t / threads; i < ctrl.size() * (t + 1) / threads; i++) {
+                if (ctrl[i] >= 0) sources[partitions + t].push_back(slots[i]);
+            }
+        });
+        
+        size_t distinctCount = 0, total = 0;
+        for (size_t p = 0; p < sources.size(); p++) {
+            if (p < partitions) distinctCount += sources[p].size();
+            total += sources[p].size();
+        }
+        if (distinctCount == 0) return;
+        
+        size_t newCapacity = GROUP_WIDTH;
+        while (total > newCapacity * maxLoadFactor) {
+            newCapacity *= 2;
+        }
+        newCapacity = std::max(newCapacity, ctrl.size());
+#if HASH_TABLE_STATS
+        if (newCapacity > ctrl.size()) counters.growResizes.add();
+        else counters.inPlaceRehashes.add();
+        counters.inserts.add(distinctCount);
+#endif
+        
+        // Region r is groups [r << regionShift, (r + 1) << regionShift)
+        int groupBits = 0;
+        while ((size_t(GROUP_WIDTH) << groupBits) < newCapacity) {
+            groupBits++;
+        }
+        const int regionBits = std::min(bits, groupBits);
+        const int regionShift = groupBits - regionBits;
+        const size_t regions = size_t(1) << regionBits;
+        const size_t mask = newCapacity / GROUP_WIDTH - 1;
+        auto regionOf = [&](int key) { return ((hasher(key) >> 7) & mask) >> regionShift; };
+        
+        // Histogram every source by region, then scatter region-major so each
+        // region's entries are contiguous
+        std::vector<std::vector<size_t>> cursors(sources.size());
+        std::atomic<size_t> nextSource(0);
+        parallelFor(threads, [&](int) {
+            for (size_t s = nextSource++; s < sources.size(); s = nextSource++) {
+                cursors[s].assign(regions, 0);
+                for (const Slot& entry : sources[s]) {
+                    cursors[s][regionOf(entry.key)]++;
+                }
+            }
+        });
+        std::vector<size_t> regionBegin(regions + 1, 0);
+        size_t position = 0;
+        for (size_t r = 0; r < regions; r++) {
+            regionBegin[r] = position;
+            for (auto& cursor : cursors) {
+                size_t n = cursor[r];
+                cursor[r] = position;
+                position += n;
+            }
+        }
+        regionBegin[regions] = position;
+        
+        std::vector<Slot> entries(total);
+        nextSource = 0;
+        parallelFor(threads, [&](int) {
+            for (size_t s = nextSource++; s < sources.size(); s = nextSource++) {
+                for (const Slot& entry : sources[s]) {
+                    entries[cursors[s][regionOf(entry.key)]++] = entry;
+                }
+                std::vector<Slot>().swap(sources[s]);
+            }
+        });
+        
+        ctrl.assign(newCapacity, static_cast<signed char>(CTRL_EMPTY));
+        slots.assign(newCapacity, Slot());
+        size_ = 0;
+        tombstones = 0;
+        
+        // A probe that runs out of its region is deferred and finished
+        // serially once the workers are done; with the table below its load
+        // factor that only happens at the edges of the regions
+        std::vector<std::vector<Slot>> deferred(threads);
+        std::vector<size_t> placed(threads, 0);
+        std::atomic<size_t> nextRegion(0);
+        parallelFor(threads, [&](int t) {
+            for (size_t r = nextRegion++; r < regions; r = nextRegion++) {
+                for (size_t i = regionBegin[r]; i < regionBegin[r + 1]; i++) {
+                    int result = bulkPlace(entries[i], r, regionShift);
+                    if (result < 0) deferred[t].push_back(entries[i]);
+                    else placed[t] += result;
+                }
+            }
+        });
+        for (int t = 0; t < threads; t++) {
+            size_ += placed[t];
+            for (const Slot& entry : deferred[t]) {
+                size_ += bulkPlace(entry, 0, groupBits);
+            }
+        }
+    }
+    
+    void bulkBuild(const std::vector<int>& values, int threads = defaultThreadCount()) {
+        bulkBuild(values.data(), values.size(), threads);
+    }
+    
+    // Number of times value was inserted (0 if absent)
+    int find(int value) const {
+#if HASH_TABLE_STATS
+        LatencySample sample(counters.lookupLatency, counters.lookups.get());
+        counters.lookups.add();
+#endif
+        size_t groupsVisited;
+        long long index = findIndex(value, hasher(value), groupsVisited);
+#if HASH_TABLE_STATS
+        recordProbe(counters.lookupProbes, groupsVisited);
+#endif
+        return index >= 0 ? slots[index].count : 0;
+    }
+    
+    // Remove value and all its copies; returns false if it was absent
+    bool erase(int value) {
+#if HASH_TABLE_STATS
+        counters.erases.add();
+#endif
+        long long index = findIndex(value, hasher(value));
+        if (index < 0) return false;
+        
+        // If the group still has an empty slot no probe ever ran past it,
+        // so the slot can go straight back to empty instead of a tombstone
+        const signed char* group = &ctrl[index / GROUP_WIDTH * GROUP_WIDTH];
+        if (matchEmpty(group)) {
+            ctrl[index] = CTRL_EMPTY;
+        } else {
+            ctrl[index] = CTRL_DELETED;
+            tombstones++;
+        }
+        size_--;
+        return true;
+    }
+    
+    // Keep one copy of each value as it arrives, so no removeDuplicates pass is needed
+    void setDedupeOnInsert(bool enabled) {
+        dedupeOnInsert = enabled;
+    }
+    
+    // Drop every key but keep the allocated capacity
+    void clear() {
+        std::fill(ctrl.begin(), ctrl.end(), static_cast<signed char>(CTRL_EMPTY));
+        size_ = 0;
+        tombstones = 0;
+    }
+    
+    // Load factor above which the table grows, in (0, 1)
+    void setMaxLoadFactor(double loadFactor) {
+        maxLoadFactor = std::min(std::max(loadFactor, 0.1), 0.95);
+    }
+    
+    double loadFactor() const {
+        return ctrl.empty() ? 0.0 : static_cast<double>(size_) / ctrl.size();
+    }
+    
+    size_t size() const {
+        return size_;
+    }
+    
+    size_t capacity() const {
+        return ctrl.size();
+    }
+    
+    // Counter snapshot; only size, capacity and tombstones unless built with HASH_TABLE_STATS=1
+    HashTableStats stats() const {
+        HashTableStats result;
+        result.size = size_;
+        result.capacity = ctrl.size();
+        result.tombstones = tombstones;
+#if HASH_TABLE_STATS
+        result.inserts = counters.inserts.get();
+        result.lookups = counters.lookups.get();
+        result.erases = counters.erases.get();
+        result.growResizes = counters.growResizes.get();
+        result.inPlaceRehashes = counters.inPlaceRehashes.get();
+        for (int i = 0; i < STATS_PROBE_BUCKETS; i++) {
+            result.insertProbes[i] = counters.insertProbes[i].get();
+            result.lookupProbes[i] = counters.lookupProbes[i].get();
+        }
+        for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+            result.insertLatency[i] = counters.insertLatency[i].get();
+            result.lookupLatency[i] = counters.lookupLatency[i].get();
+        }
+#endif
+        return result;
+    }
+    
+    // Calls fn(key, count) for every distinct key
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (size_t i = 0; i < ctrl.size(); i++) {
+            if (ctrl[i] >= 0) fn(slots[i].key, slots[i].count);
+        }
+    }
+    
+    // Remove duplicates: keep a single copy of every key
+    void removeDuplicates() {
+        for (size_t i = 0; i < ctrl.size(); i++) {
+            if (ctrl[i] >= 0) slots[i].count = 1;
+        }
+    }
+    
+    // Entries of one bucket-view slot (keys with that first digit), sorted,
+    // each repeated as many times as it was inserted
+    std::vector<int> bucketView(int slot) const {
+        std::vector<int> entries;
+        forEach([&](int key, int count) {
+            if (hashFunction(key) == slot) entries.insert(entries.end(), count, key);
+        });
+        std::sort(entries.begin(), entries.end());
+        return entries;
+    }
+    
     // Display a specific slot
     void displaySlot(int slot) {
         if (slot < 0 || slot >= TABLE_SIZE) {
@@ -44,10 +751,11 @@ public:
         
         std::cout << "Slot " << slot << " (Numbers starting with digit " << slot << "): ";
         
-        if (table[slot].empty()) {
+        std::vector<int> entries = bucketView(slot);
+        if (entries.empty()) {
             std::cout << "No entries" << std::endl;
         } else {
-            for (int num : table[slot]) {
+            for (int num : entries) {
                 std::cout << num << " ";
             }
             std::cout << std::endl;
@@ -59,10 +767,11 @@ public:
         std::cout << "\nAll slots in the hash table:" << std::endl;
         for (int i = 0; i < TABLE_SIZE; i++) {
             std::cout << "Slot " << i << ": ";
-            if (table[i].empty()) {
+            std::vector<int> entries = bucketView(i);
+            if (entries.empty()) {
                 std::cout << "Empty";
             } else {
-                for (int num : table[i]) {
+                for (int num : entries) {
                     std::cout << num << " ";
                 }
             }
@@ -70,12 +779,375 @@ public:
         }
     }
     
-    // Get table size
+    // Get table size (number of bucket-view slots)
     int getTableSize() const {
         return TABLE_SIZE;
     }
 };
 
+typedef BasicHashTable<> HashTable;
+
+// ===================== STREAMING DISTINCT =====================
+// Emits every distinct value of a stream once, in a single pass over the input.
+// Values are emitted as soon as they are first seen while the in-memory table
+// is under maxKeysInMemory. After that, values not already in the table are
+// spilled to temporary files partitioned by hash bits, and each partition is
+// deduplicated afterwards with the same budget, so memory stays bounded no
+// matter how many distinct values the stream holds.
+
+const int DISTINCT_PARTITIONS = 16;
+const int DISTINCT_MAX_LEVEL = 8;  // 4 hash bits per level; past this, ignore the budget
+
+// Reads a partition file back as a distinct() source
+struct SpillReader {
+    std::FILE* file;
+    bool operator()(int& value) {
+        return std::fread(&value, sizeof(int), 1, file) == 1;
+    }
+};
+
+// Source: bool next(int& value), Emit: void emit(int value)
+template <typename Source, typename Emit>
+size_t distinctFromSource(Source& next, Emit& emit, size_t maxKeysInMemory, int level) {
+    size_t emitted = 0;
+    std::vector<std::FILE*> spill;
+    
+    {
+        HashTable seen;
+        seen.setDedupeOnInsert(true);
+        IntHash hasher;
+        bool spilling = false;
+        int value;
+        
+        while (next(value)) {
+            if (!spilling || seen.find(value)) {
+                if (seen.insert(value)) {
+                    emit(value);
+                    emitted++;
+                    spilling = seen.size() >= maxKeysInMemory && level < DISTINCT_MAX_LEVEL;
+                }
+                continue;
+            }
+            
+            // Table is at its budget: defer unseen values to a partition file
+            if (spill.empty()) {
+                for (int p = 0; p < DISTINCT_PARTITIONS; p++) {
+                    std::FILE* file = std::tmpfile();
+                    if (file == nullptr) {
+                        throw std::runtime_error("distinct: could not create spill file");
+                    }
+                    spill.push_back(file);
+                }
+            }
+            int partition = static_cast<int>((hasher(value) >> (60 - 4 * level)) & (DISTINCT_PARTITIONS - 1));
+            std::fwrite(&value, sizeof(int), 1, spill[partition]);
+        }
+    } // release the first table before reading the partitions back
+    
+    for (std::FILE* file : spill) {
+        std::rewind(file);
+        SpillReader readSpill = {file};
+        emitted += distinctFromSource(readSpill, emit, maxKeysInMemory, level + 1);
+        std::fclose(file);
+    }
+    
+    return emitted;
+}
+
+// Distinct values of [first, last), passed to emit(int). Returns how many were emitted.
+template <typename InputIt, typename Emit>
+size_t distinct(InputIt first, InputIt last, Emit emit, size_t maxKeysInMemory = 1 << 24) {
+    auto next = [&first, &last](int& value) {
+        if (first == last) return false;
+        value = *first;
+        ++first;
+        return true;
+    };
+    return distinctFromSource(next, emit, maxKeysInMemory, 0);
+}
+
+// Distinct whitespace-separated integers of a file, written one per line to out
+size_t distinctFile(const std::string& path, std::ostream& out, size_t maxKeysInMemory = 1 << 24) {
+    std::ifstream in(path);
+    if (!in.is_open()) {
+        std::cout << "Error: Could not open input file '" << path << "'" << std::endl;
+        return 0;
+    }
+    return distinct(std::istream_iterator<int>(in), std::istream_iterator<int>(),
+                    [&out](int value) { out << value << '\n'; }, maxKeysInMemory);
+}
+
+// ===================== CONCURRENT SHARDED TABLE =====================
+// Thread-safe table for several producer threads. Keys are split over
+// 2^shardBits independent BasicHashTables by the top bits of the hash, each
+// behind its own reader/writer lock. finds on a shard run in parallel, and a
+// shard grows on its own, so a resize only blocks the threads using that shard.
+template <typename Hash = IntHash>
+class BasicConcurrentHashTable {
+private:
+    struct Shard {
+        mutable std::shared_timed_mutex lock;
+        BasicHashTable<Hash> table;
+        char padding[64];  // keep neighbouring shard locks off the same cache line
+    };
+    
+    std::vector<Shard> shards;
+    int shardShift;
+    Hash hasher;
+    
+    Shard& shardFor(int value) {
+        return shards[static_cast<size_t>(hasher(value)) >> shardShift];
+    }
+    
+    const Shard& shardFor(int value) const {
+        return shards[static_cast<size_t>(hasher(value)) >> shardShift];
+    }
+    
+public:
+    BasicConcurrentHashTable(int shardBits = 6, const Hash& hash = Hash())
+        : shards(size_t(1) << shardBits), shardShift(static_cast<int>(sizeof(size_t) * 8) - shardBits), hasher(hash) {
+        for (auto& shard : shards) {
+            shard.table = BasicHashTable<Hash>(hash);
+        }
+    }
+    
+    bool insert(int value) {
+        Shard& shard = shardFor(value);
+        std::unique_lock<std::shared_timed_mutex> guard(shard.lock);
+        return shard.table.insert(value);
+    }
+    
+    int find(int value) const {
+        const Shard& shard = shardFor(value);
+        std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+        return shard.table.find(value);
+    }
+    
+    bool erase(int value) {
+        Shard& shard = shardFor(value);
+        std::unique_lock<std::shared_timed_mutex> guard(shard.lock);
+        return shard.table.erase(value);
+    }
+    
+    // Not synchronized with writers; call before the producer threads start
+    void setDedupeOnInsert(bool enabled) {
+        for (auto& shard : shards) {
+            shard.table.setDedupeOnInsert(enabled);
+        }
+    }
+    
+    void setMaxLoadFactor(double loadFactor) {
+        for (auto& shard : shards) {
+            shard.table.setMaxLoadFactor(loadFactor);
+        }
+    }
+    
+    // Sum over shards; each shard is read under its own lock
+    size_t size() const {
+        size_t total = 0;
+        for (const auto& shard : shards) {
+            std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+            total += shard.table.size();
+        }
+        return total;
+    }
+    
+    // Parallel load before the table is shared: the input is radix-partitioned
+    // by the same hash bits that pick the shard, so every worker fills whole
+    // shards from a contiguous array and no two threads touch the same shard
+    void bulkBuild(const int* data, size_t count, int threads = defaultThreadCount()) {
+        int bits = static_cast<int>(sizeof(size_t) * 8) - shardShift;
+        RadixPartitions parts = radixPartition(data, count, bits, hasher, threads);
+        
+        std::atomic<size_t> nextShard(0);
+        parallelFor(threads, [&](int) {
+            for (size_t p = nextShard++; p < shards.size(); p = nextShard++) {
+                std::unique_lock<std::shared_timed_mutex> guard(shards[p].lock);
+                shards[p].table.reserve(shards[p].table.size() + parts.offsets[p + 1] - parts.offsets[p]);
+                for (size_t i = parts.offsets[p]; i < parts.offsets[p + 1]; i++) {
+                    shards[p].table.insert(parts.values[i]);
+                }
+            }
+        });
+    }
+    
+    void bulkBuild(const std::vector<int>& values, int threads = defaultThreadCount()) {
+        bulkBuild(values.data(), values.size(), threads);
+    }
+    
+    // Counters summed over all shards
+    HashTableStats stats() const {
+        HashTableStats total;
+        for (const auto& shard : shards) {
+            std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+            total.add(shard.table.stats());
+        }
+        return total;
+    }
+    
+    // Calls fn(key, count) for every distinct key, one shard at a time
+    template <typename Fn>
+    void forEach(Fn fn) const {
+        for (const auto& shard : shards) {
+            std::shared_lock<std::shared_timed_mutex> guard(shard.lock);
+            shard.table.forEach(fn);
+        }
+    }
+};
+
+typedef BasicConcurrentHashTable<> ConcurrentHashTable;
+
+// ===================== SKETCH MODE =====================
+// Approximate answers in a few kilobytes when the exact table is not needed:
+// a HyperLogLog for the number of distinct values and a count-min sketch for
+// per-value frequency, plus a short list of the heaviest values seen.
+// Sketches from different threads can be combined with merge().
+template <typename Hash = IntHash>
+class BasicHashSketch {
+private:
+    static const int HLL_BITS = 12;                 // 4096 registers, ~1.6% standard error
+    static const int HLL_REGISTERS = 1 << HLL_BITS;
+    static const int CMS_DEPTH = 4;
+    static const int CMS_WIDTH = 2048;              // error <= total / CMS_WIDTH * e with prob 1 - e^-depth
+    static const int TOP_K = 16;
+    
+    std::vector<unsigned char> registers;
+    std::vector<uint32_t> counters;  // CMS_DEPTH rows of CMS_WIDTH
+    std::vector<std::pair<int, uint32_t>> heavyHitters;
+    uint64_t total = 0;
+    Hash hasher;
+    
+    uint64_t hashOf(int value) const {
+        return static_cast<uint64_t>(hasher(value));
+    }
+    
+    // Each row remixes the value hash with its own seed (splitmix64 finalizer),
+    // so two values that collide in one row are unlikely to collide in the others
+    size_t cmsIndex(uint64_t hash, int row) const {
+        uint64_t h = hash + (row + 1) * 0x9E3779B97F4A7C15ULL;
+        h = (h ^ (h >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        h = (h ^ (h >> 27)) * 0x94d049bb133111ebULL;
+        h ^= h >> 31;
+        return row * CMS_WIDTH + static_cast<size_t>(h % CMS_WIDTH);
+    }
+    
+    uint32_t cmsEstimate(uint64_t hash) const {
+        uint32_t estimate = UINT32_MAX;
+        for (int row = 0; row < CMS_DEPTH; row++) {
+            estimate = std::min(estimate, counters[cmsIndex(hash, row)]);
+        }
+        return estimate;
+    }
+    
+    // Keep the TOP_K values with the largest estimates
+    void offerHeavyHitter(int value, uint32_t estimate) {
+        for (auto& entry : heavyHitters) {
+            if (entry.first == value) {
+                entry.second = estimate;
+                return;
+            }
+        }
+        if (heavyHitters.size() < TOP_K) {
+            heavyHitters.push_back(std::make_pair(value, estimate));
+            return;
+        }
+        auto smallest = std::min_element(heavyHitters.begin(), heavyHitters.end(),
+            [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) { return a.second < b.second; });
+        if (estimate > smallest->second) {
+            *smallest = std::make_pair(value, estimate);
+        }
+    }
+    
+public:
+    BasicHashSketch(const Hash& hash = Hash())
+        : registers(HLL_REGISTERS, 0), counters(CMS_DEPTH * CMS_WIDTH, 0), hasher(hash) {}
+    
+    // Same call as HashTable::insert so either can consume the stream
+    void insert(int value) {
+        uint64_t hash = hashOf(value);
+        
+        // HyperLogLog: top bits pick the register, the rest give the rank
+        size_t reg = static_cast<size_t>(hash >> (64 - HLL_BITS));
+        uint64_t rest = (hash << HLL_BITS) | (uint64_t(1) << (HLL_BITS - 1));
+        unsigned char rank = 1;
+        while (!(rest & (uint64_t(1) << 63))) {
+            rest <<= 1;
+            rank++;
+        }
+        registers[reg] = std::max(registers[reg], rank);
+        
+        // Count-min with conservative update: only raise the rows at the minimum
+        uint32_t estimate = cmsEstimate(hash) + 1;
+        for (int row = 0; row < CMS_DEPTH; row++) {
+            uint32_t& counter = counters[cmsIndex(hash, row)];
+            counter = std::max(counter, estimate);
+        }
+        total++;
+        offerHeavyHitter(value, estimate);
+    }
+    
+    // Estimated number of distinct values
+    double distinctEstimate() const {
+        double sum = 0.0;
+        int zeros = 0;
+        for (unsigned char r : registers) {
+            sum += std::ldexp(1.0, -r);
+            if (r == 0) zeros++;
+        }
+        const double m = HLL_REGISTERS;
+        double estimate = 0.7213 / (1.0 + 1.079 / m) * m * m / sum;
+        
+        // Small range: linear counting is more accurate while registers are empty
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * std::log(m / zeros);
+        }
+        return estimate;
+    }
+    
+    // Estimated number of times value was inserted (never below the true count)
+    uint32_t frequencyEstimate(int value) const {
+        return cmsEstimate(hashOf(value));
+    }
+    
+    // Heaviest values seen, largest estimate first
+    std::vector<std::pair<int, uint32_t>> topValues() const {
+        std::vector<std::pair<int, uint32_t>> result = heavyHitters;
+        std::sort(result.begin(), result.end(),
+            [](const std::pair<int, uint32_t>& a, const std::pair<int, uint32_t>& b) { return a.second > b.second; });
+        return result;
+    }
+    
+    uint64_t totalInserted() const {
+        return total;
+    }
+    
+    // Fold in a sketch built from another part of the stream (e.g. another thread)
+    void merge(const BasicHashSketch& other) {
+        for (int i = 0; i < HLL_REGISTERS; i++) {
+            registers[i] = std::max(registers[i], other.registers[i]);
+        }
+        for (size_t i = 0; i < counters.size(); i++) {
+            counters[i] += other.counters[i];
+        }
+        total += other.total;
+        
+        // Re-rank both candidate lists against the merged counters
+        std::vector<std::pair<int, uint32_t>> candidates = heavyHitters;
+        candidates.insert(candidates.end(), other.heavyHitters.begin(), other.heavyHitters.end());
+        heavyHitters.clear();
+        for (const auto& candidate : candidates) {
+            offerHeavyHitter(candidate.first, frequencyEstimate(candidate.first));
+        }
+    }
+    
+    size_t memoryBytes() const {
+        return registers.size() + counters.size() * sizeof(uint32_t)
+             + heavyHitters.capacity() * sizeof(std::pair<int, uint32_t>);
+    }
+};
+
+typedef BasicHashSketch<> HashSketch;
+
 // Function to generate random integers in range [10, 99]
 std::vector<int> generateRandomNumbers(int count) {
     std::vector<int> numbers;
@@ -90,26 +1162,123 @@ std::vector<int> generateRandomNumbers(int count) {
     return numbers;
 }
 
-int main() {
+// ===================== CONCURRENT BENCHMARK =====================
+// hashHashing.exe --bench-concurrent [totalOps]: insert-only and 90% lookup
+// mixes on ConcurrentHashTable for 1 to 64 threads, printed as JSON
+void runConcurrentBenchmark(long long totalOps) {
+    const int threadCounts[] = {1, 2, 4, 8, 16, 32, 64};
+    const char* mixes[] = {"insert_only", "lookup_90"};
+    
+    std::cout << "{\"total_ops\": " << totalOps << ", \"hardware_threads\": "
+              << std::thread::hardware_concurrency() << ", \"results\": [";
+    bool first = true;
+    
+    for (int mix = 0; mix < 2; mix++) {
+        for (int threads : threadCounts) {
+            ConcurrentHashTable table;
+            long long opsPerThread = totalOps / threads;
+            
+            // The lookup mix runs against a table that already holds the key range
+            if (mix == 1) {
+                for (int key = 0; key < totalOps / 10; key++) {
+                    table.insert(key);
+                }
+            }
+            
+            std::atomic<long long> hits(0);
+            auto start = std::chrono::steady_clock::now();
+            std::vector<std::thread> workers;
+            for (int t = 0; t < threads; t++) {
+                workers.emplace_back([&, t]() {
+                    std::mt19937 gen(1234 + t);
+                    std::uniform_int_distribution<int> keyDist(0, static_cast<int>(std::min(totalOps, 1LL << 30)));
+                    long long localHits = 0;
+                    for (long long i = 0; i < opsPerThread; i++) {
+                        int key = keyDist(gen);
+                        if (mix == 1 && gen() % 10 != 0) {
+                            localHits += table.find(key) > 0;
+                        } else {
+                            table.insert(key);
+                        }
+                    }
+                    hits += localHits;
+                });
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            
+            std::cout << (first ? "" : ",") << "\n  {\"mix\": \"" << mixes[mix] << "\", \"threads\": " << threads
+                      << ", \"ops_per_sec\": " << static_cast<long long>(opsPerThread * threads / seconds)
+                      << ", \"lookup_hits\": " << hits.load() << ", \"final_size\": " << table.size() << "}";
+            std::cout.flush();
+            first = false;
+        }
+    }
+    std::cout << "\n]}" << std::endl;
+}
+
+int main(int argc, char* argv[]) {
     const int NUM_COUNT = 1000;
     
-    std::cout << "=== Hash Table with Chaining Implementation ===" << std::endl;
+    // hashHashing.exe --distinct <input> [maxKeysInMemory]: stream the unique integers to stdout
+    if (argc > 2 && std::string(argv[1]) == "--distinct") {
+        size_t budget = argc > 3 ? std::stoull(argv[3]) : (1 << 24);
+        std::ios::sync_with_stdio(false);
+        size_t count = distinctFile(argv[2], std::cout, budget);
+        std::cerr << count << " distinct values" << std::endl;
+        return 0;
+    }
+    
+    if (argc > 1 && std::string(argv[1]) == "--bench-concurrent") {
+        // At least one operation per thread at 64 threads; the prefill loop counts keys in an int
+        const long long MIN_OPS = 64, MAX_OPS = 1LL << 32;
+        long long totalOps = 8000000;
+        if (argc > 2) {
+            std::string value = argv[2];
+            size_t used = 0;
+            try {
+                totalOps = std::stoll(value, &used);
+            } catch (const std::exception&) {
+                used = 0;
+            }
+            if (used == 0 || used != value.size() || totalOps < MIN_OPS || totalOps > MAX_OPS) {
+                std::cerr << "Error: totalOps must be a number in [" << MIN_OPS << ", " << MAX_OPS << "]" << std::endl;
+                return 1;
+            }
+        }
+        runConcurrentBenchmark(totalOps);
+        return 0;
+    }
+    
+    std::cout << "=== Open-Addressing Hash Table Implementation ===" << std::endl;
     
     // (a) Generate random integers
     std::cout << "Generating " << NUM_COUNT << " random integers in range [10, 99]..." << std::endl;
     std::vector<int> randomNumbers = generateRandomNumbers(NUM_COUNT);
     
-    // Create hash table and insert numbers
+    // (b) Create hash table and load the numbers in one batch, dropping duplicates as they arrive
+    std::cout << "Inserting numbers, duplicates are rejected at insert time..." << std::endl;
     HashTable hashTable;
+    hashTable.setDedupeOnInsert(true);
+    hashTable.bulkBuild(randomNumbers);
+    int duplicates = NUM_COUNT - static_cast<int>(hashTable.size());
+    
+    std::cout << "Insertion completed, " << duplicates << " duplicates rejected." << std::endl;
+    
+    // Same stream through the sketch, for comparison with the exact table
+    HashSketch sketch;
     for (int num : randomNumbers) {
-        hashTable.insert(num);
+        sketch.insert(num);
     }
+    std::cout << "Sketch (" << sketch.memoryBytes() / 1024 << " KB) estimates "
+              << static_cast<int>(sketch.distinctEstimate() + 0.5) << " distinct values, most frequent: "
+              << sketch.topValues()[0].first << " (~" << sketch.topValues()[0].second << " times)" << std::endl;
     
-    std::cout << "Initial insertion completed." << std::endl;
-    
-    // (b) Remove duplicates from all chains
-    std::cout << "Removing duplicates from hash table..." << std::endl;
-    hashTable.removeDuplicates();
+#if HASH_TABLE_STATS
+    std::cout << "Table stats: " << hashTable.stats().toJson() << std::endl;
+#endif
     
     // Display table size information
     std::cout << "\nHash table has " << hashTable.getTableSize() << " slots (0-9)" << std::endl;
@@ -1,155 +1,2601 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <unordered_map>
-#include <unordered_set>
+#include <string_view>
 #include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <cmath>
+#include <queue>
+#include <tuple>
+#include <functional>
+#include <atomic>
+#include <chrono>
+#include <list>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <csignal>
+#include <cerrno>
+#include <thread>
+#include <unordered_map>
+#include <sstream>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+// SSE2 case folding on x86/x64, plain byte loop everywhere else
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPELL_USE_SSE2
+#endif
+
+// AVX2 batch edit distance and case folding when the compiler targets it (/arch:AVX2, -mavx2)
+#if defined(__AVX2__)
+#include <immintrin.h>
+#define SPELL_USE_AVX2
+#endif
 #include <algorithm>
 #include <cctype>
 
-class SpellChecker {
+// ===================== THREADS AND FILES =====================
+
+// Runs fn(t) on threads t = 0..threads-1 and waits for all of them
+template <typename Fn>
+void parallelFor(int threads, Fn fn) {
+    std::vector<std::thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(fn, t);
+    }
+    fn(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+int defaultThreadCount() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// Read-only view of a whole file, mapped into memory instead of read into a buffer
+class MappedFile {
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#ifdef _WIN32
+    HANDLE file = INVALID_HANDLE_VALUE;
+    HANDLE mapping = NULL;
+#endif
+    
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    
+    ~MappedFile() {
+        close();
+    }
+    
+    bool open(const std::string& path) {
+        close();
+#ifdef _WIN32
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                           FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+        if (file == INVALID_HANDLE_VALUE) return false;
+        LARGE_INTEGER fileSize;
+        if (!GetFileSizeEx(file, &fileSize)) {
+            close();
+            return false;
+        }
+        length = static_cast<size_t>(fileSize.QuadPart);
+        if (length == 0) return true;  // empty files cannot be mapped
+        mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (mapping == NULL) {
+            close();
+            return false;
+        }
+        bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        length = static_cast<size_t>(info.st_size);
+        if (length == 0) {
+            ::close(fd);
+            return true;
+        }
+        void* view = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);  // the mapping keeps the file alive
+        if (view != MAP_FAILED) {
+            bytes = static_cast<const char*>(view);
+            madvise(view, length, MADV_SEQUENTIAL);
+        }
+#endif
+        if (bytes == nullptr) {
+            close();
+            return false;
+        }
+        return true;
+    }
+    
+    void close() {
+#ifdef _WIN32
+        if (bytes != nullptr) UnmapViewOfFile(bytes);
+        if (mapping != NULL) CloseHandle(mapping);
+        if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+        mapping = NULL;
+        file = INVALID_HANDLE_VALUE;
+#else
+        if (bytes != nullptr) munmap(const_cast<char*>(bytes), length);
+#endif
+        bytes = nullptr;
+        length = 0;
+    }
+    
+    const char* data() const {
+        return bytes;
+    }
+    
+    size_t size() const {
+        return length;
+    }
+};
+
+// ===================== DICTIONARY IMAGES =====================
+// A compiled dictionary is one binary file holding every array of the word
+// storage and the indexes back to back, each 8-byte aligned. Loading maps the
+// file and points the arrays at it, so nothing is parsed or copied and the
+// pages are shared by every process using the same image. Images are only
+// meant for the machine (byte order, struct layout) that compiled them.
+
+// Array that either owns its elements or views elements stored elsewhere
+// (a mapped image). Reads work the same either way; edit() turns a view back
+// into an owned vector that can be changed.
+template <typename T>
+class FlatArray {
+private:
+    std::vector<T> owned;
+    const T* view = nullptr;
+    size_t viewSize = 0;
+    
+public:
+    std::vector<T>& edit() {
+        if (view != nullptr) {
+            owned.assign(view, view + viewSize);
+            view = nullptr;
+            viewSize = 0;
+        }
+        return owned;
+    }
+    
+    void borrow(const T* data, size_t count) {
+        std::vector<T>().swap(owned);
+        view = data;
+        viewSize = count;
+    }
+    
+    const T* data() const { return view != nullptr ? view : owned.data(); }
+    size_t size() const { return view != nullptr ? viewSize : owned.size(); }
+    bool empty() const { return size() == 0; }
+    const T& operator[](size_t i) const { return data()[i]; }
+    const T* begin() const { return data(); }
+    const T* end() const { return data() + size(); }
+    
+    // Heap bytes only; a view into a mapped image costs shared pages, not heap
+    size_t memoryBytes() const {
+        return owned.capacity() * sizeof(T);
+    }
+};
+
+class ImageWriter {
+private:
+    std::ofstream out;
+    uint64_t position = 0;
+    
+    void align() {
+        static const char zeros[8] = {0};
+        if (position % 8 != 0) bytes(zeros, 8 - position % 8);
+    }
+    
+public:
+    explicit ImageWriter(const std::string& path) : out(path, std::ios::binary) {}
+    
+    bool ok() const {
+        return static_cast<bool>(out);
+    }
+    
+    void bytes(const void* data, size_t count) {
+        out.write(static_cast<const char*>(data), count);
+        position += count;
+    }
+    
+    template <typename T>
+    void value(const T& v) {
+        bytes(&v, sizeof(T));
+    }
+    
+    // Element count, then the elements starting at the next 8-byte boundary
+    template <typename T>
+    void array(const FlatArray<T>& values) {
+        value<uint64_t>(values.size());
+        align();
+        bytes(values.data(), values.size() * sizeof(T));
+        align();
+    }
+};
+
+class ImageReader {
+private:
+    const char* base;
+    size_t length;
+    size_t position = 0;
+    
+    bool align() {
+        position = (position + 7) & ~size_t(7);
+        return position <= length;
+    }
+    
+public:
+    ImageReader(const char* data, size_t size) : base(data), length(size) {}
+    
+    bool bytes(void* out, size_t count) {
+        if (count > length - position) return false;
+        std::memcpy(out, base + position, count);
+        position += count;
+        return true;
+    }
+    
+    template <typename T>
+    bool value(T& v) {
+        return bytes(&v, sizeof(T));
+    }
+    
+    // Points values at the next array in the image; fails if it runs past the end
+    template <typename T>
+    bool array(FlatArray<T>& values) {
+        uint64_t count = 0;
+        if (!value(count) || !align() || count > (length - position) / sizeof(T)) return false;
+        values.borrow(reinterpret_cast<const T*>(base + position), static_cast<size_t>(count));
+        position += static_cast<size_t>(count) * sizeof(T);
+        return align();
+    }
+};
+
+// ===================== CASE FOLDING =====================
+// Dictionary words are stored lower case, so every lookup folds its input
+// first. Only the ASCII letters A-Z change; every other byte, including all
+// bytes of multi-byte UTF-8 characters (which are >= 0x80), is copied as is.
+// That is what ::tolower does in the "C" locale, minus its undefined
+// behaviour for negative chars.
+
+// Writes the lower-case form of in[0 .. count) to out (which may equal in)
+inline void foldAsciiLower(const char* in, size_t count, char* out) {
+    size_t i = 0;
+#ifdef SPELL_USE_AVX2
+    {
+        // Signed compares: bytes >= 0x80 are negative, so never in 'A'..'Z'
+        const __m256i belowA = _mm256_set1_epi8('A' - 1);
+        const __m256i aboveZ = _mm256_set1_epi8('Z' + 1);
+        const __m256i caseBit = _mm256_set1_epi8(0x20);
+        for (; i + 32 <= count; i += 32) {
+            __m256i bytes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in + i));
+            __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(bytes, belowA), _mm256_cmpgt_epi8(aboveZ, bytes));
+            bytes = _mm256_or_si256(bytes, _mm256_and_si256(upper, caseBit));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + i), bytes);
+        }
+    }
+#endif
+#ifdef SPELL_USE_SSE2
+    {
+        const __m128i belowA = _mm_set1_epi8('A' - 1);
+        const __m128i aboveZ = _mm_set1_epi8('Z' + 1);
+        const __m128i caseBit = _mm_set1_epi8(0x20);
+        for (; i + 16 <= count; i += 16) {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+            __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(bytes, belowA), _mm_cmplt_epi8(bytes, aboveZ));
+            bytes = _mm_or_si128(bytes, _mm_and_si128(upper, caseBit));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), bytes);
+        }
+    }
+#endif
+    for (; i < count; i++) {
+        char c = in[i];
+        out[i] = (c >= 'A' && c <= 'Z') ? static_cast<char>(c | 0x20) : c;
+    }
+}
+
+// Lower-case copy of a word that lives on the stack when the word is short
+// enough (nearly always), so folding a lookup key allocates nothing
+class FoldedWord {
+private:
+    static const size_t INLINE_SIZE = 64;
+    char inlineBuffer[INLINE_SIZE];
+    std::string longBuffer;
+    std::string_view folded;
+    
+public:
+    explicit FoldedWord(std::string_view word) {
+        char* out = inlineBuffer;
+        if (word.size() > INLINE_SIZE) {
+            longBuffer.resize(word.size());
+            out = &longBuffer[0];
+        }
+        foldAsciiLower(word.data(), word.size(), out);
+        folded = std::string_view(out, word.size());
+    }
+    
+    FoldedWord(const FoldedWord&) = delete;
+    FoldedWord& operator=(const FoldedWord&) = delete;
+    
+    std::string_view view() const {
+        return folded;
+    }
+};
+
+// ===================== WORD STORAGE =====================
+// All dictionary words live back to back in one char arena. A word is known
+// by its id (its position in load order, so the most common words have the
+// lowest ids) and addressed as an {offset, length} pair into the arena.
+
+struct WordRef {
+    uint32_t offset;
+    uint32_t length;
+};
+
+// 64-bit FNV-1a
+inline uint64_t hashWord(std::string_view word) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : word) {
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+class WordDictionary {
+private:
+    static const uint32_t EMPTY_SLOT = 0;  // slots hold id + 1
+    
+    struct Slot {
+        uint32_t idPlusOne;
+        uint32_t hashTag;  // upper hash bits, checked before comparing characters
+    };
+    
+    FlatArray<char> arena;
+    FlatArray<WordRef> words;
+    FlatArray<Slot> slots;  // open addressing, linear probing, power-of-two size
+    
+    void growSlots() {
+        std::vector<Slot>& table = slots.edit();
+        std::vector<Slot> old;
+        old.swap(table);
+        table.assign(old.empty() ? 1024 : old.size() * 2, Slot{EMPTY_SLOT, 0});
+        size_t mask = table.size() - 1;
+        for (const Slot& slot : old) {
+            if (slot.idPlusOne == EMPTY_SLOT) continue;
+            size_t i = hashWord(word(slot.idPlusOne - 1)) & mask;
+            while (table[i].idPlusOne != EMPTY_SLOT) i = (i + 1) & mask;
+            table[i] = slot;
+        }
+    }
+    
+public:
+    // Adds a word (already lowercased); returns false if it was already present
+    bool add(std::string_view word) {
+        if (slots.empty() || (words.size() + 1) * 2 > slots.size()) {
+            growSlots();  // keep load factor at or below 0.5
+        }
+        
+        uint64_t hash = hashWord(word);
+        uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        size_t mask = slots.size() - 1;
+        size_t i = hash & mask;
+        while (slots[i].idPlusOne != EMPTY_SLOT) {
+            if (slots[i].hashTag == tag && this->word(slots[i].idPlusOne - 1) == word) {
+                return false;
+            }
+            i = (i + 1) & mask;
+        }
+        
+        WordRef ref = {static_cast<uint32_t>(arena.size()), static_cast<uint32_t>(word.size())};
+        arena.edit().insert(arena.edit().end(), word.begin(), word.end());
+        words.edit().push_back(ref);
+        slots.edit()[i] = Slot{static_cast<uint32_t>(words.size()), tag};
+        return true;
+    }
+    
+    // Call once after the last add(): trims the arena
+    void finish() {
+        arena.edit().shrink_to_fit();
+        words.edit().shrink_to_fit();
+    }
+    
+    // Id of word, or -1 if it is not in the dictionary
+    long long find(std::string_view word) const {
+        return find(word, hashWord(word));
+    }
+    
+    // find() for a caller that already has hashWord(word)
+    long long find(std::string_view word, uint64_t hash) const {
+        if (slots.empty()) return -1;
+        uint32_t tag = static_cast<uint32_t>(hash >> 32);
+        size_t mask = slots.size() - 1;
+        for (size_t i = hash & mask; slots[i].idPlusOne != EMPTY_SLOT; i = (i + 1) & mask) {
+            if (slots[i].hashTag == tag && this->word(slots[i].idPlusOne - 1) == word) {
+                return slots[i].idPlusOne - 1;
+            }
+        }
+        return -1;
+    }
+    
+    bool contains(std::string_view word) const {
+        return find(word) >= 0;
+    }
+    
+    bool contains(std::string_view word, uint64_t hash) const {
+        return find(word, hash) >= 0;
+    }
+    
+    std::string_view word(uint32_t id) const {
+        return std::string_view(arena.data() + words[id].offset, words[id].length);
+    }
+    
+    uint32_t size() const {
+        return static_cast<uint32_t>(words.size());
+    }
+    
+    // Position of the word's characters in the arena
+    uint32_t arenaOffset(uint32_t id) const {
+        return words[id].offset;
+    }
+    
+    const char* arenaData() const {
+        return arena.data();
+    }
+    
+    size_t arenaSize() const {
+        return arena.size();
+    }
+    
+    // Hash of every word in order, used to tell whether a saved index still matches
+    uint64_t fingerprint() const {
+        uint64_t hash = hashWord(std::string_view(arena.data(), arena.size()));
+        for (const WordRef& ref : words) {
+            hash = (hash ^ ref.length) * 1099511628211ULL;
+        }
+        return hash;
+    }
+    
+    size_t memoryBytes() const {
+        return arena.memoryBytes() + words.memoryBytes() + slots.memoryBytes();
+    }
+    
+    void writeImage(ImageWriter& out) const {
+        out.array(arena);
+        out.array(words);
+        out.array(slots);
+    }
+    
+    // Maps the arrays and checks every index stored in them, so a corrupt
+    // image is rejected instead of read out of bounds
+    bool readImage(ImageReader& in) {
+        if (!in.array(arena) || !in.array(words) || !in.array(slots)) return false;
+        for (const WordRef& ref : words) {
+            if (ref.offset > arena.size() || ref.length > arena.size() - ref.offset) return false;
+        }
+        if (slots.empty()) return words.empty();
+        
+        // Lookups mask with slots.size() - 1 and stop at an empty slot
+        if ((slots.size() & (slots.size() - 1)) != 0) return false;
+        size_t used = 0;
+        for (const Slot& slot : slots) {
+            if (slot.idPlusOne == EMPTY_SLOT) continue;
+            if (slot.idPlusOne > words.size()) return false;
+            used++;
+        }
+        return used < slots.size();
+    }
+};
+
+// ===================== BLOOM FILTER =====================
+// Split-block Bloom filter over the dictionary's word hashes. Every word maps
+// to one 32-byte block (half a cache line) and sets one bit in each of the
+// block's eight 32-bit lanes, so a query touches one block: one cache miss,
+// and with AVX2 one multiply, one shift and one test. A miss means the word is
+// certainly not in the dictionary; a hit still needs the exact lookup.
+class BloomFilter {
+private:
+    struct Block {
+        uint32_t lanes[8];
+    };
+    
+    // Odd multipliers that pick each lane's bit from the low hash bits
+    static constexpr uint32_t SALTS[8] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                          0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+    
+    FlatArray<Block> blocks;
+    double estimatedRate = 1.0;
+    
+    // FNV-1a's bits are too correlated to split into a block index and eight
+    // bit positions, so they are remixed with the murmur3 finalizer first
+    static uint64_t mix(uint64_t hash) {
+        hash ^= hash >> 33;
+        hash *= 0xff51afd7ed558ccdULL;
+        hash ^= hash >> 33;
+        hash *= 0xc4ceb9fe1a85ec53ULL;
+        hash ^= hash >> 33;
+        return hash;
+    }
+    
+    // Multiply-shift on the high bits maps onto any block count
+    static size_t blockIndex(uint64_t mixed, size_t blockCount) {
+        return static_cast<size_t>(((mixed >> 32) * blockCount) >> 32);
+    }
+    
+    // Expected false-positive rate with keys spread over blockCount blocks: a
+    // block holding i keys answers yes to a stranger when all eight of its
+    // probed bits are set, and the keys per block are Poisson distributed
+    static double falsePositiveRate(size_t keys, size_t blockCount) {
+        double perBlock = static_cast<double>(keys) / blockCount;
+        double probability = std::exp(-perBlock);  // Poisson(i = 0)
+        double rate = 0.0;
+        for (int i = 0; i < perBlock * 4 + 64; i++) {
+            if (i > 0) probability *= perBlock / i;
+            rate += probability * std::pow(1.0 - std::pow(31.0 / 32.0, i), 8);
+        }
+        return rate;
+    }
+    
+public:
+    // Sizes the filter for at most the given false-positive rate and adds every word
+    void build(const WordDictionary& dictionary, double targetRate) {
+        size_t keys = std::max<uint32_t>(1, dictionary.size());
+        size_t blockCount = keys / 64 + 1;  // 4 bits per key to start with
+        while ((estimatedRate = falsePositiveRate(keys, blockCount)) > targetRate && blockCount < keys * 8) {
+            blockCount += blockCount / 8 + 1;
+        }
+        
+        std::vector<Block>& table = blocks.edit();
+        table.assign(blockCount, Block{{0}});
+        for (uint32_t id = 0; id < dictionary.size(); id++) {
+            uint64_t mixed = mix(hashWord(dictionary.word(id)));
+            Block& block = table[blockIndex(mixed, table.size())];
+            for (int lane = 0; lane < 8; lane++) {
+                block.lanes[lane] |= 1u << ((static_cast<uint32_t>(mixed) * SALTS[lane]) >> 27);
+            }
+        }
+    }
+    
+    // False only if the word with this hashWord() is certainly not in the dictionary
+    bool mayContain(uint64_t hash) const {
+        uint64_t mixed = mix(hash);
+        const Block& block = blocks[blockIndex(mixed, blocks.size())];
+#ifdef SPELL_USE_AVX2
+        __m256i salts = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(SALTS));
+        __m256i shifts = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(mixed)), salts), 27);
+        __m256i bits = _mm256_sllv_epi32(_mm256_set1_epi32(1), shifts);
+        __m256i lanes = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block.lanes));
+        return _mm256_testc_si256(lanes, bits) != 0;  // every probed bit is set
+#else
+        uint32_t missing = 0;
+        for (int lane = 0; lane < 8; lane++) {
+            missing |= ~block.lanes[lane] & (1u << ((static_cast<uint32_t>(mixed) * SALTS[lane]) >> 27));
+        }
+        return missing == 0;
+#endif
+    }
+    
+    bool empty() const {
+        return blocks.empty();
+    }
+    
+    // False-positive rate the filter was sized for
+    double expectedFalsePositiveRate() const {
+        return estimatedRate;
+    }
+    
+    size_t memoryBytes() const {
+        return blocks.memoryBytes();
+    }
+    
+    void writeImage(ImageWriter& out) const {
+        out.value(estimatedRate);
+        out.array(blocks);
+    }
+    
+    bool readImage(ImageReader& in) {
+        return in.value(estimatedRate) && in.array(blocks);
+    }
+};
+
+// ===================== PREFIX TRIE =====================
+// Compressed (radix) trie over the dictionary for completions of any prefix.
+// Edge labels point into the dictionary arena instead of holding copies, and
+// every node knows the most frequent word below it (lowest id, since the
+// dictionary file lists common words first). Completions come out best-first
+// from a small heap, so the top k cost O(k log k) node visits regardless of
+// how many words share the prefix. Nodes are stored in one flat array with
+// the children of a node next to each other, sorted by first character.
+class PrefixTrie {
 private:
-    std::unordered_map<std::string, bool> dictionary;
-    std::unordered_map<std::string, std::vector<std::string>> prefixMap;
+    static const uint32_t NO_WORD = UINT32_MAX;
+    
+    struct Node {
+        uint32_t labelOffset;  // edge label is arena[labelOffset .. labelOffset + labelLength)
+        uint32_t labelLength;
+        uint32_t firstChild;   // children are nodes[firstChild .. firstChild + childCount)
+        uint32_t childCount;
+        uint32_t wordId;       // word ending at this node, or NO_WORD
+        uint32_t bestWordId;   // most frequent word in the subtree
+        uint32_t wordCount;    // words in the subtree
+        uint16_t minLength;    // shortest and longest word in the subtree (capped at 65535)
+        uint16_t maxLength;
+    };
+    
+    FlatArray<Node> nodes;
+    const WordDictionary* dictionary = nullptr;
+    uint64_t longestWord = 0;
+    
+    std::string_view label(const Node& node) const {
+        return std::string_view(dictionary->arenaData() + node.labelOffset, node.labelLength);
+    }
+    
+    // Extends the DP rows through node's label, reports a word ending there and
+    // descends into the children. rows holds one row of target.size() + 1 cells
+    // per depth; row depth is the distance from target's prefixes to the path so far.
+    // Cell j of row i is at least |i - j| (the length gap), so only the band
+    // |i - j| <= maxDistance is computed; the cells just outside it hold
+    // maxDistance + 1, which stands for "too far" in every min() that reads them.
+    template <typename Found>
+    void fuzzyWalk(uint32_t index, size_t depth, std::string_view target, int maxDistance,
+                   std::vector<int>& rows, Found& found) const {
+        const Node& node = nodes[index];
+        const size_t width = target.size() + 1;
+        const size_t band = static_cast<size_t>(maxDistance);
+        const int tooFar = maxDistance + 1;
+        
+        // The same length gap bound for the whole subtree, before any cell is computed
+        if (node.maxLength + band < target.size() || node.minLength > target.size() + band) return;
+        
+        for (char c : label(node)) {
+            const int* previous = rows.data() + depth * width;
+            int* current = rows.data() + (depth + 1) * width;
+            size_t row = depth + 1;
+            size_t lo = row > band ? row - band : 1;
+            size_t hi = std::min(target.size(), row + band);
+            
+            current[0] = row <= band ? static_cast<int>(row) : tooFar;
+            current[lo - 1] = lo > 1 ? tooFar : current[0];
+            int rowMin = current[0];
+            for (size_t j = lo; j <= hi; j++) {
+                int cost = previous[j - 1] + (target[j - 1] == c ? 0 : 1);
+                current[j] = std::min(cost, std::min(previous[j], current[j - 1]) + 1);
+                rowMin = std::min(rowMin, current[j]);
+            }
+            if (hi < target.size()) current[hi + 1] = tooFar;
+            depth++;
+            // Every word below extends this path, and distances never shrink along it
+            if (rowMin > maxDistance) return;
+        }
+        
+        // Words more than maxDistance shorter or longer than target never reach the band's last cell
+        bool inBand = depth + band >= target.size() && target.size() + band >= depth;
+        int distance = inBand ? rows[depth * width + target.size()] : tooFar;
+        if (node.wordId != NO_WORD && distance <= maxDistance) {
+            found(node.wordId, distance);
+        }
+        for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; child++) {
+            fuzzyWalk(child, depth, target, maxDistance, rows, found);
+        }
+    }
+    
+    // Fills nodes[index] from sortedIds[lo, hi), all sharing their first depth characters
+    void buildNode(uint32_t index, const std::vector<uint32_t>& sortedIds, size_t lo, size_t hi, size_t depth) {
+        std::string_view first = dictionary->word(sortedIds[lo]);
+        std::string_view last = dictionary->word(sortedIds[hi - 1]);
+        
+        // In sorted order the common prefix of the range is that of its first and last word
+        size_t common = depth;
+        while (common < first.size() && common < last.size() && first[common] == last[common]) {
+            common++;
+        }
+        
+        Node node = {dictionary->arenaOffset(sortedIds[lo]) + static_cast<uint32_t>(depth),
+                     static_cast<uint32_t>(common - depth), 0, 0, NO_WORD, UINT32_MAX,
+                     static_cast<uint32_t>(hi - lo), UINT16_MAX, 0};
+        // Sorted order puts the shortest word first, but the longest can be anywhere
+        for (size_t i = lo; i < hi; i++) {
+            size_t length = std::min<size_t>(dictionary->word(sortedIds[i]).size(), UINT16_MAX);
+            node.minLength = std::min(node.minLength, static_cast<uint16_t>(length));
+            node.maxLength = std::max(node.maxLength, static_cast<uint16_t>(length));
+        }
+        if (first.size() == common) {
+            node.wordId = sortedIds[lo];  // the shortest word of the range ends here
+            lo++;
+        }
+        
+        // One child per distinct next character
+        std::vector<std::pair<size_t, size_t>> groups;
+        for (size_t i = lo; i < hi; ) {
+            char c = dictionary->word(sortedIds[i])[common];
+            size_t j = i + 1;
+            while (j < hi && dictionary->word(sortedIds[j])[common] == c) j++;
+            groups.push_back(std::make_pair(i, j));
+            i = j;
+        }
+        
+        node.firstChild = static_cast<uint32_t>(nodes.size());
+        node.childCount = static_cast<uint32_t>(groups.size());
+        nodes.edit().resize(nodes.size() + groups.size());
+        
+        node.bestWordId = node.wordId;
+        for (size_t g = 0; g < groups.size(); g++) {
+            uint32_t child = node.firstChild + static_cast<uint32_t>(g);
+            buildNode(child, sortedIds, groups[g].first, groups[g].second, common);
+            node.bestWordId = std::min(node.bestWordId, nodes[child].bestWordId);
+        }
+        nodes.edit()[index] = node;
+    }
+    
+public:
+    void build(const WordDictionary& words) {
+        dictionary = &words;
+        nodes.edit().clear();
+        if (words.size() == 0) return;
+        
+        std::vector<uint32_t> sortedIds(words.size());
+        longestWord = 0;
+        for (uint32_t id = 0; id < words.size(); id++) {
+            sortedIds[id] = id;
+            longestWord = std::max<uint64_t>(longestWord, words.word(id).size());
+        }
+        std::sort(sortedIds.begin(), sortedIds.end(),
+                  [&words](uint32_t a, uint32_t b) { return words.word(a) < words.word(b); });
+        
+        nodes.edit().resize(1);
+        buildNode(0, sortedIds, 0, sortedIds.size(), 0);
+        nodes.edit().shrink_to_fit();
+    }
+    
+    // Node whose subtree holds exactly the words starting with prefix, or -1
+    long long findPrefix(std::string_view prefix) const {
+        if (nodes.empty()) return -1;
+        uint32_t current = 0;
+        size_t matched = 0;
+        
+        while (true) {
+            std::string_view edge = label(nodes[current]);
+            size_t n = std::min(edge.size(), prefix.size() - matched);
+            if (edge.compare(0, n, prefix.substr(matched, n)) != 0) return -1;
+            matched += n;
+            if (matched == prefix.size()) return current;
+            
+            // Binary search the sorted children for the next character
+            const Node& node = nodes[current];
+            const Node* begin = nodes.data() + node.firstChild;
+            const Node* end = begin + node.childCount;
+            char next = prefix[matched];
+            const Node* child = std::lower_bound(begin, end, next, [this](const Node& a, char c) {
+                return label(a)[0] < c;
+            });
+            if (child == end || label(*child)[0] != next) return -1;
+            current = static_cast<uint32_t>(child - nodes.data());
+        }
+    }
+    
+    // Up to k words starting with prefix, most frequent first, as views into the arena
+    std::vector<std::string_view> topCompletions(std::string_view prefix, size_t k) const {
+        std::vector<std::string_view> result;
+        long long start = findPrefix(prefix);
+        if (start < 0 || k == 0) return result;
+        
+        // Min-heap on word id: (id, node, 1) is a word ready to emit, (id, node, 0) a subtree to expand
+        typedef std::tuple<uint32_t, uint32_t, int> Entry;
+        std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> heap;
+        heap.push(Entry(nodes[start].bestWordId, static_cast<uint32_t>(start), 0));
+        
+        while (!heap.empty() && result.size() < k) {
+            Entry top = heap.top();
+            heap.pop();
+            const Node& node = nodes[std::get<1>(top)];
+            if (std::get<2>(top)) {
+                result.push_back(dictionary->word(std::get<0>(top)));
+                continue;
+            }
+            if (node.wordId != NO_WORD) {
+                heap.push(Entry(node.wordId, std::get<1>(top), 1));
+            }
+            for (uint32_t c = node.firstChild; c < node.firstChild + node.childCount; c++) {
+                heap.push(Entry(nodes[c].bestWordId, c, 0));
+            }
+        }
+        return result;
+    }
+    
+    // Number of words starting with prefix
+    size_t countCompletions(std::string_view prefix) const {
+        long long node = findPrefix(prefix);
+        return node < 0 ? 0 : nodes[node].wordCount;
+    }
+    
+    // Calls found(wordId, distance) for every word within maxDistance of target.
+    // Walks the trie like a Levenshtein automaton: one DP row per character on the
+    // path, and a branch is dropped as soon as its whole row exceeds maxDistance.
+    template <typename Found>
+    void fuzzyQuery(std::string_view target, int maxDistance, Found found) const {
+        if (nodes.empty() || target.size() > longestWord + maxDistance) return;
+        std::vector<int> rows((static_cast<size_t>(longestWord) + 1) * (target.size() + 1));
+        for (size_t j = 0; j <= target.size(); j++) rows[j] = std::min(static_cast<int>(j), maxDistance + 1);
+        fuzzyWalk(0, 0, target, maxDistance, rows, found);
+    }
+    
+    // Length of the longest word; nothing is within d edits of a longer target than this plus d
+    size_t longestWordLength() const {
+        return static_cast<size_t>(longestWord);
+    }
+    
+    size_t memoryBytes() const {
+        return nodes.memoryBytes();
+    }
+    
+    void writeImage(ImageWriter& out) const {
+        out.value(longestWord);
+        out.array(nodes);
+    }
+    
+    // Maps the nodes and checks them: labels inside the arena, word ids and
+    // child ranges in range, every node the child of exactly one earlier node,
+    // and no path longer than longestWord, which sizes fuzzyQuery's rows
+    bool readImage(ImageReader& in, const WordDictionary& words) {
+        dictionary = &words;
+        if (!in.value(longestWord) || !in.array(nodes)) return false;
+        
+        uint64_t longest = 0;
+        for (uint32_t id = 0; id < words.size(); id++) {
+            longest = std::max<uint64_t>(longest, words.word(id).size());
+        }
+        if (longestWord != longest) return false;
+        if (nodes.empty()) return true;
+        
+        const uint64_t UNREACHED = UINT64_MAX;
+        std::vector<uint64_t> depth(nodes.size(), UNREACHED);
+        depth[0] = nodes[0].labelLength;
+        for (size_t i = 0; i < nodes.size(); i++) {
+            const Node& node = nodes[i];
+            if (depth[i] == UNREACHED || depth[i] > longestWord) return false;
+            if (node.labelOffset > words.arenaSize() || node.labelLength > words.arenaSize() - node.labelOffset) {
+                return false;
+            }
+            if ((node.wordId != NO_WORD && node.wordId >= words.size()) || node.bestWordId >= words.size()) {
+                return false;
+            }
+            if (node.childCount == 0) continue;
+            if (node.firstChild <= i || node.firstChild > nodes.size() || node.childCount > nodes.size() - node.firstChild) {
+                return false;
+            }
+            for (uint32_t child = node.firstChild; child < node.firstChild + node.childCount; child++) {
+                if (depth[child] != UNREACHED || nodes[child].labelLength == 0) return false;
+                depth[child] = depth[i] + nodes[child].labelLength;
+            }
+        }
+        return true;
+    }
+};
+
+// ===================== EDIT DISTANCE KERNELS =====================
+// Levenshtein distance with Myers' bit-parallel algorithm (Hyyro's form):
+// a DP column is kept as +1/-1 vertical delta bit vectors, so each text
+// character costs a handful of word operations and no memory is allocated.
+// The pattern table is built once per query word and reused for every
+// candidate. Patterns longer than 64 characters fall back to a two-row DP.
+
+// Plain DP, only used for words longer than 64 characters
+inline int dpEditDistance(std::string_view word1, std::string_view word2) {
+    std::vector<int> previous(word2.size() + 1), current(word2.size() + 1);
+    for (size_t j = 0; j <= word2.size(); j++) previous[j] = static_cast<int>(j);
+    
+    for (size_t i = 1; i <= word1.size(); i++) {
+        current[0] = static_cast<int>(i);
+        for (size_t j = 1; j <= word2.size(); j++) {
+            if (word1[i - 1] == word2[j - 1]) {
+                current[j] = previous[j - 1];
+            } else {
+                current[j] = 1 + std::min({previous[j], current[j - 1], previous[j - 1]});
+            }
+        }
+        previous.swap(current);
+    }
+    return previous[word2.size()];
+}
+
+class MyersPattern {
+private:
+    uint64_t peq[256];  // bit i of peq[c] is set where pattern[i] == c
+    std::string_view pattern;
+    
+#ifdef SPELL_USE_AVX2
+    // Four texts at once, one per 64-bit lane; a lane stops scoring at the end of its text
+    void distance4(const std::string_view* texts, int* out) const {
+        const __m256i zero = _mm256_setzero_si256();
+        const __m256i ones = _mm256_set1_epi64x(-1);
+        const __m256i one = _mm256_set1_epi64x(1);
+        const __m256i last = _mm256_set1_epi64x(static_cast<long long>(1ULL << (pattern.size() - 1)));
+        const __m256i lengths = _mm256_set_epi64x(texts[3].size(), texts[2].size(), texts[1].size(), texts[0].size());
+        size_t longest = std::max(std::max(texts[0].size(), texts[1].size()), std::max(texts[2].size(), texts[3].size()));
+        
+        __m256i pv = ones, mv = zero;
+        __m256i score = _mm256_set1_epi64x(static_cast<long long>(pattern.size()));
+        auto eqAt = [&](int lane, size_t j) -> long long {
+            return j < texts[lane].size() ? static_cast<long long>(peq[static_cast<unsigned char>(texts[lane][j])]) : 0;
+        };
+        
+        for (size_t j = 0; j < longest; j++) {
+            __m256i eq = _mm256_set_epi64x(eqAt(3, j), eqAt(2, j), eqAt(1, j), eqAt(0, j));
+            __m256i xv = _mm256_or_si256(eq, mv);
+            __m256i xh = _mm256_or_si256(_mm256_xor_si256(_mm256_add_epi64(_mm256_and_si256(eq, pv), pv), pv), eq);
+            __m256i ph = _mm256_or_si256(mv, _mm256_xor_si256(_mm256_or_si256(xh, pv), ones));
+            __m256i mh = _mm256_and_si256(pv, xh);
+            
+            __m256i active = _mm256_cmpgt_epi64(lengths, _mm256_set1_epi64x(static_cast<long long>(j)));
+            __m256i up = _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(ph, last), zero), ones);
+            __m256i down = _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(mh, last), zero), ones);
+            score = _mm256_sub_epi64(score, _mm256_and_si256(up, active));   // masks are -1, so sub adds 1
+            score = _mm256_add_epi64(score, _mm256_and_si256(down, active));
+            
+            ph = _mm256_or_si256(_mm256_slli_epi64(ph, 1), one);
+            mh = _mm256_slli_epi64(mh, 1);
+            pv = _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), ones));
+            mv = _mm256_and_si256(ph, xv);
+        }
+        
+        alignas(32) long long lanes[4];
+        _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), score);
+        for (int lane = 0; lane < 4; lane++) out[lane] = static_cast<int>(lanes[lane]);
+    }
+#endif
+    
+public:
+    explicit MyersPattern(std::string_view text) : pattern(text) {
+        std::memset(peq, 0, sizeof(peq));
+        if (text.size() <= 64) {
+            for (size_t i = 0; i < text.size(); i++) {
+                peq[static_cast<unsigned char>(text[i])] |= 1ULL << i;
+            }
+        }
+    }
+    
+    int distance(std::string_view text) const {
+        return boundedDistance(text, INT_MAX - 1);
+    }
+    
+    // Exact distance when it is <= maxDistance, otherwise some value > maxDistance.
+    // Stops as soon as the remaining characters can no longer bring it back in range.
+    int boundedDistance(std::string_view text, int maxDistance) const {
+        int m = static_cast<int>(pattern.size());
+        int n = static_cast<int>(text.size());
+        if (std::abs(m - n) > maxDistance) return maxDistance + 1;
+        if (m == 0) return n;
+        if (m > 64) return dpEditDistance(pattern, text);
+        
+        uint64_t pv = ~0ULL, mv = 0;
+        const uint64_t last = 1ULL << (m - 1);
+        int score = m;
+        
+        for (int j = 0; j < n; j++) {
+            uint64_t eq = peq[static_cast<unsigned char>(text[j])];
+            uint64_t xv = eq | mv;
+            uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+            uint64_t ph = mv | ~(xh | pv);
+            uint64_t mh = pv & xh;
+            
+            if (ph & last) score++;
+            else if (mh & last) score--;
+            
+            ph = (ph << 1) | 1;  // row 0 of the DP grows by one per text character
+            mh <<= 1;
+            pv = mh | ~(xv | ph);
+            mv = ph & xv;
+            
+            // Each remaining character can lower the score by at most one
+            if (score - (n - 1 - j) > maxDistance) return maxDistance + 1;
+        }
+        return score;
+    }
+    
+    // Distances to count texts, written to out. With AVX2 four texts are
+    // advanced per instruction; otherwise they are scored one by one.
+    void distanceBatch(const std::string_view* texts, size_t count, int* out) const {
+        size_t i = 0;
+#ifdef SPELL_USE_AVX2
+        if (!pattern.empty() && pattern.size() <= 64) {
+            for (; i + 4 <= count; i += 4) {
+                distance4(texts + i, out + i);
+            }
+        }
+#endif
+        for (; i < count; i++) {
+            out[i] = distance(texts[i]);
+        }
+    }
+};
+
+// ===================== BK-TREE =====================
+// Metric tree over edit distance. Every child hangs off its parent at the
+// distance between the two words, so a query within k of the target only has
+// to enter children whose edge distance is within k of the parent's distance
+// (triangle inequality). Nodes are kept in one flat array.
+class BKTree {
+private:
+    static const uint32_t NO_NODE = UINT32_MAX;
+    
+    struct Node {
+        uint32_t wordId;
+        uint32_t firstChild;
+        uint32_t nextSibling;
+        uint32_t parentDistance;
+    };
+    
+    FlatArray<Node> nodes;
+    
+public:
+    void build(const WordDictionary& dictionary) {
+        std::vector<Node>& tree = nodes.edit();
+        tree.clear();
+        tree.reserve(dictionary.size());
+        
+        for (uint32_t id = 0; id < dictionary.size(); id++) {
+            Node node = {id, NO_NODE, NO_NODE, 0};
+            if (tree.empty()) {
+                tree.push_back(node);
+                continue;
+            }
+            
+            MyersPattern word(dictionary.word(id));
+            uint32_t current = 0;
+            while (true) {
+                uint32_t d = word.distance(dictionary.word(tree[current].wordId));
+                if (d == 0) break;  // duplicate word
+                
+                uint32_t child = tree[current].firstChild;
+                while (child != NO_NODE && tree[child].parentDistance != d) {
+                    child = tree[child].nextSibling;
+                }
+                if (child != NO_NODE) {
+                    current = child;
+                    continue;
+                }
+                
+                node.parentDistance = d;
+                node.nextSibling = tree[current].firstChild;
+                tree[current].firstChild = static_cast<uint32_t>(tree.size());
+                tree.push_back(node);
+                break;
+            }
+        }
+        tree.shrink_to_fit();
+    }
+    
+    // Calls found(wordId, distance) for every word within maxDistance of target.
+    // Pending nodes are scored in batches so the SIMD kernel has lanes to fill.
+    template <typename Found>
+    void query(const WordDictionary& dictionary, const MyersPattern& target, int maxDistance, Found found) const {
+        if (nodes.empty()) return;
+        
+        const size_t BATCH = 8;
+        std::vector<uint32_t> stack(1, 0);
+        uint32_t batch[BATCH];
+        std::string_view words[BATCH];
+        int distances[BATCH];
+        
+        while (!stack.empty()) {
+            size_t count = std::min(BATCH, stack.size());
+            for (size_t b = 0; b < count; b++) {
+                batch[b] = stack.back();
+                stack.pop_back();
+                words[b] = dictionary.word(nodes[batch[b]].wordId);
+            }
+            target.distanceBatch(words, count, distances);
+            
+            for (size_t b = 0; b < count; b++) {
+                const Node& node = nodes[batch[b]];
+                int d = distances[b];
+                if (d <= maxDistance) {
+                    found(node.wordId, d);
+                }
+                for (uint32_t child = node.firstChild; child != NO_NODE; child = nodes[child].nextSibling) {
+                    int edge = static_cast<int>(nodes[child].parentDistance);
+                    if (edge >= d - maxDistance && edge <= d + maxDistance) {
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+    }
+    
+    size_t memoryBytes() const {
+        return nodes.memoryBytes();
+    }
+    
+    void writeImage(ImageWriter& out) const {
+        out.array(nodes);
+    }
+    
+    // Maps the nodes and checks that every word id and child or sibling index
+    // is in range and that each node is reached once from the root, so a
+    // corrupt image cannot send a query out of bounds or around a cycle
+    bool readImage(ImageReader& in, const WordDictionary& dictionary) {
+        if (!in.array(nodes)) return false;
+        if (nodes.empty()) return true;
+        
+        std::vector<bool> seen(nodes.size(), false);
+        std::vector<uint32_t> stack(1, 0);
+        seen[0] = true;
+        while (!stack.empty()) {
+            const Node& node = nodes[stack.back()];
+            stack.pop_back();
+            if (node.wordId >= dictionary.size()) return false;
+            for (uint32_t child = node.firstChild; child != NO_NODE; child = nodes[child].nextSibling) {
+                if (child >= nodes.size() || seen[child]) return false;
+                seen[child] = true;
+                stack.push_back(child);
+            }
+        }
+        return true;
+    }
+};
+
+// ===================== DELETION INDEX =====================
+// SymSpell-style index: every word is listed under all strings obtained by
+// deleting up to maxDistance of its characters. Two words within maxDistance
+// edits always share such a delete, so a query only has to look up its own
+// deletes and verify the few words found there. Deletes are stored as 32-bit
+// hashes; most deletes belong to a single word, whose id is stored right in
+// the hash slot, and the rest point at shared lists of word ids. Hash
+// collisions only add candidates that the verification step drops.
+
+// Largest edit distance a suggestion search may use; a saved index or image
+// claiming more is treated as corrupt
+const int MAX_SUGGEST_DISTANCE = 64;
+
+class DeletionIndex {
+private:
+    static const uint32_t EMPTY_SLOT = UINT32_MAX;
+    static const uint32_t SINGLE_WORD = 0x80000000u;  // value is a word id, not a group
+    
+    struct Slot {
+        uint32_t hash;
+        uint32_t value;  // SINGLE_WORD | word id, or a group index
+    };
+    
+    int maxDistance = 0;
+    uint64_t dictionaryFingerprint = 0;
+    FlatArray<Slot> slots;             // delete hash -> word or group, linear probing at ~85% load
+    FlatArray<uint32_t> groupOffsets;  // ids of group g are postings[groupOffsets[g] .. groupOffsets[g + 1])
+    FlatArray<uint32_t> postings;
+    
+    // Home slot of a hash; multiply-shift maps onto any table size, not just powers of two
+    size_t homeSlot(uint32_t hash) const {
+        return static_cast<size_t>((static_cast<uint64_t>(hash) * slots.size()) >> 32);
+    }
+    
+    static uint32_t hashDelete(std::string_view text) {
+        uint64_t hash = hashWord(text);
+        return static_cast<uint32_t>(hash ^ (hash >> 32));
+    }
+    
+    // Hashes of buffer with up to remaining more characters deleted at positions >= from
+    static void collectDeletes(std::string& buffer, size_t from, int remaining, std::vector<uint32_t>& out) {
+        out.push_back(hashDelete(buffer));
+        if (remaining == 0) return;
+        for (size_t i = from; i < buffer.size(); i++) {
+            char removed = buffer[i];
+            buffer.erase(i, 1);
+            collectDeletes(buffer, i, remaining - 1, out);
+            buffer.insert(buffer.begin() + i, removed);
+        }
+    }
+    
+    static std::vector<uint32_t> uniqueDeletes(std::string_view word, int distance) {
+        std::vector<uint32_t> hashes;
+        std::string buffer(word);
+        collectDeletes(buffer, 0, distance, hashes);
+        std::sort(hashes.begin(), hashes.end());
+        hashes.erase(std::unique(hashes.begin(), hashes.end()), hashes.end());
+        return hashes;
+    }
+    
+    // Every stored word id and group index in range, and an empty slot to end
+    // every probe; checked before a saved index is used
+    bool valid(const WordDictionary& dictionary) const {
+        if (maxDistance < 0 || maxDistance > MAX_SUGGEST_DISTANCE) return false;
+        if (slots.empty()) return true;
+        
+        bool hasEmpty = false;
+        for (const Slot& slot : slots) {
+            if (slot.value == EMPTY_SLOT) {
+                hasEmpty = true;
+            } else if (slot.value & SINGLE_WORD) {
+                if ((slot.value & ~SINGLE_WORD) >= dictionary.size()) return false;
+            } else if (static_cast<size_t>(slot.value) + 1 >= groupOffsets.size()) {
+                return false;
+            }
+        }
+        if (!hasEmpty) return false;
+        for (size_t g = 0; g + 1 < groupOffsets.size(); g++) {
+            if (groupOffsets[g] > groupOffsets[g + 1]) return false;
+        }
+        if (!groupOffsets.empty() && groupOffsets[groupOffsets.size() - 1] > postings.size()) return false;
+        for (uint32_t id : postings) {
+            if (id >= dictionary.size()) return false;
+        }
+        return true;
+    }
+    
+    const Slot* findSlot(uint32_t hash) const {
+        for (size_t i = homeSlot(hash); slots[i].value != EMPTY_SLOT; i = (i + 1 == slots.size()) ? 0 : i + 1) {
+            if (slots[i].hash == hash) return &slots[i];
+        }
+        return nullptr;
+    }
+    
+    template <typename T>
+    static void writeArray(std::ofstream& out, const FlatArray<T>& values) {
+        uint64_t count = values.size();
+        out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        out.write(reinterpret_cast<const char*>(values.data()), count * sizeof(T));
+    }
+    
+    // Fails on a count larger than what is left of the file, before allocating for it
+    template <typename T>
+    static bool readArray(std::ifstream& in, uint64_t fileSize, FlatArray<T>& array) {
+        std::vector<T>& values = array.edit();
+        uint64_t count = 0;
+        if (!in.read(reinterpret_cast<char*>(&count), sizeof(count))) return false;
+        std::streamoff position = in.tellg();
+        if (position < 0 || static_cast<uint64_t>(position) > fileSize
+            || count > (fileSize - static_cast<uint64_t>(position)) / sizeof(T)) {
+            return false;
+        }
+        values.resize(count);
+        return static_cast<bool>(in.read(reinterpret_cast<char*>(values.data()), count * sizeof(T)));
+    }
+    
+public:
+    void build(const WordDictionary& dictionary, int distance) {
+        maxDistance = distance;
+        dictionaryFingerprint = dictionary.fingerprint();
+        
+        // (delete hash, word id) pairs, sorted so every hash becomes one run
+        std::vector<uint64_t> pairs;
+        for (uint32_t id = 0; id < dictionary.size(); id++) {
+            for (uint32_t hash : uniqueDeletes(dictionary.word(id), distance)) {
+                pairs.push_back((static_cast<uint64_t>(hash) << 32) | id);
+            }
+        }
+        std::sort(pairs.begin(), pairs.end());
+        
+        std::vector<Slot> entries;
+        std::vector<uint32_t>& offsets = groupOffsets.edit();
+        std::vector<uint32_t>& ids = postings.edit();
+        offsets.clear();
+        ids.clear();
+        for (size_t i = 0, j; i < pairs.size(); i = j) {
+            uint32_t hash = static_cast<uint32_t>(pairs[i] >> 32);
+            for (j = i + 1; j < pairs.size() && static_cast<uint32_t>(pairs[j] >> 32) == hash; j++) {}
+            
+            if (j - i == 1) {
+                entries.push_back(Slot{hash, SINGLE_WORD | static_cast<uint32_t>(pairs[i])});
+                continue;
+            }
+            entries.push_back(Slot{hash, static_cast<uint32_t>(offsets.size())});
+            offsets.push_back(static_cast<uint32_t>(ids.size()));
+            for (size_t k = i; k < j; k++) {
+                ids.push_back(static_cast<uint32_t>(pairs[k]));
+            }
+        }
+        offsets.push_back(static_cast<uint32_t>(ids.size()));
+        std::vector<uint64_t>().swap(pairs);
+        
+        std::vector<Slot>& table = slots.edit();
+        table.assign(entries.size() * 100 / 85 + 16, Slot{0, EMPTY_SLOT});
+        for (const Slot& entry : entries) {
+            size_t i = homeSlot(entry.hash);
+            while (table[i].value != EMPTY_SLOT) i = (i + 1 == table.size()) ? 0 : i + 1;
+            table[i] = entry;
+        }
+    }
+    
+    // Calls found(wordId, distance) for every word within maxDistance of target
+    template <typename Found>
+    void query(const WordDictionary& dictionary, std::string_view target, const MyersPattern& pattern,
+               int queryDistance, Found found) const {
+        if (slots.empty()) return;
+        queryDistance = std::min(queryDistance, maxDistance);
+        
+        std::vector<uint32_t> candidates;
+        for (uint32_t hash : uniqueDeletes(target, queryDistance)) {
+            const Slot* slot = findSlot(hash);
+            if (slot == nullptr) continue;
+            if (slot->value & SINGLE_WORD) {
+                candidates.push_back(slot->value & ~SINGLE_WORD);
+            } else {
+                candidates.insert(candidates.end(), postings.begin() + groupOffsets[slot->value],
+                                  postings.begin() + groupOffsets[slot->value + 1]);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+        
+        for (uint32_t id : candidates) {
+            // Banded check: gives up as soon as the distance must exceed queryDistance
+            int d = pattern.boundedDistance(dictionary.word(id), queryDistance);
+            if (d <= queryDistance) {
+                found(id, d);
+            }
+        }
+    }
+    
+    // Binary image: magic, max distance, dictionary fingerprint, then the three arrays
+    bool save(const std::string& path) const {
+        std::ofstream out(path, std::ios::binary);
+        if (!out.is_open()) return false;
+        out.write("SYMDEL02", 8);
+        uint32_t distance = maxDistance;
+        out.write(reinterpret_cast<const char*>(&distance), sizeof(distance));
+        out.write(reinterpret_cast<const char*>(&dictionaryFingerprint), sizeof(dictionaryFingerprint));
+        writeArray(out, slots);
+        writeArray(out, groupOffsets);
+        writeArray(out, postings);
+        return static_cast<bool>(out);
+    }
+    
+    // Loads a saved index; fails if it is missing, corrupt, or was built for other words or distance
+    bool load(const std::string& path, const WordDictionary& dictionary, int distance) {
+        std::ifstream in(path, std::ios::binary | std::ios::ate);
+        if (!in.is_open()) return false;
+        uint64_t fileSize = static_cast<uint64_t>(std::max<std::streamoff>(in.tellg(), 0));
+        in.seekg(0);
+        
+        char magic[8];
+        uint32_t savedDistance = 0;
+        uint64_t savedFingerprint = 0;
+        if (!in.read(magic, 8) || std::string_view(magic, 8) != "SYMDEL02") return false;
+        in.read(reinterpret_cast<char*>(&savedDistance), sizeof(savedDistance));
+        in.read(reinterpret_cast<char*>(&savedFingerprint), sizeof(savedFingerprint));
+        if (!in || static_cast<int>(savedDistance) != distance || savedFingerprint != dictionary.fingerprint()) {
+            return false;
+        }
+        maxDistance = distance;
+        if (!readArray(in, fileSize, slots) || !readArray(in, fileSize, groupOffsets)
+            || !readArray(in, fileSize, postings) || !valid(dictionary)) {
+            slots.edit().clear();
+            return false;
+        }
+        dictionaryFingerprint = savedFingerprint;
+        return true;
+    }
+    
+    size_t memoryBytes() const {
+        return slots.memoryBytes() + groupOffsets.memoryBytes() + postings.memoryBytes();
+    }
+    
+    void writeImage(ImageWriter& out) const {
+        out.value<int32_t>(maxDistance);
+        out.value(dictionaryFingerprint);
+        out.array(slots);
+        out.array(groupOffsets);
+        out.array(postings);
+    }
+    
+    bool readImage(ImageReader& in, const WordDictionary& dictionary) {
+        int32_t distance = 0;
+        if (!in.value(distance) || !in.value(dictionaryFingerprint)) return false;
+        maxDistance = distance;
+        return in.array(slots) && in.array(groupOffsets) && in.array(postings) && valid(dictionary);
+    }
+};
+
+// ===================== SUGGESTION CACHE =====================
+// Bounded LRU cache from a lower-cased misspelling to its suggestion ("" when
+// there is none). Words are split over 2^shardBits shards by the top bits of
+// their hash, each with its own lock, list in recency order and index into
+// that list, so threads looking up different words rarely wait for each other.
+class SuggestionCache {
+public:
+    struct Stats {
+        uint64_t hits;
+        uint64_t misses;
+        uint64_t evictions;
+        
+        double hitRate() const {
+            return hits + misses == 0 ? 0.0 : static_cast<double>(hits) / (hits + misses);
+        }
+    };
+    
+private:
+    struct Entry {
+        std::string word;
+        std::string suggestion;
+    };
+    
+    struct Shard {
+        std::mutex lock;
+        std::list<Entry> entries;  // most recently used first
+        std::unordered_map<std::string_view, std::list<Entry>::iterator> index;  // keys view entries' words
+        char padding[64];  // keep neighbouring shard locks off the same cache line
+    };
+    
+    std::vector<Shard> shards;
+    int shardShift;
+    size_t shardCapacity;
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+    
+    Shard& shardFor(std::string_view word) {
+        return shards[static_cast<size_t>(hashWord(word) >> shardShift)];
+    }
+    
+public:
+    // capacity is the total number of cached words (0 disables the cache)
+    explicit SuggestionCache(size_t capacity = 4096, int shardBits = 4)
+        : shards(size_t(1) << shardBits), shardShift(64 - shardBits) {
+        setCapacity(capacity);
+    }
+    
+    // Drops every entry; not safe to call while other threads use the cache
+    void setCapacity(size_t capacity) {
+        shardCapacity = (capacity + shards.size() - 1) / shards.size();
+        clear();
+    }
+    
+    bool find(std::string_view word, std::string& suggestion) {
+        if (shardCapacity == 0) return false;
+        Shard& shard = shardFor(word);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        auto found = shard.index.find(word);
+        if (found == shard.index.end()) {
+            misses.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        shard.entries.splice(shard.entries.begin(), shard.entries, found->second);
+        suggestion = found->second->suggestion;
+        hits.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+    
+    void insert(std::string_view word, const std::string& suggestion) {
+        if (shardCapacity == 0) return;
+        Shard& shard = shardFor(word);
+        std::lock_guard<std::mutex> guard(shard.lock);
+        if (shard.index.count(word)) return;  // another thread got there first
+        
+        if (shard.entries.size() >= shardCapacity) {
+            shard.index.erase(shard.entries.back().word);
+            shard.entries.pop_back();
+            evictions.fetch_add(1, std::memory_order_relaxed);
+        }
+        shard.entries.push_front(Entry{std::string(word), suggestion});
+        shard.index.emplace(shard.entries.front().word, shard.entries.begin());
+    }
+    
+    // Forget every cached suggestion, e.g. because the dictionary changed
+    void clear() {
+        for (Shard& shard : shards) {
+            std::lock_guard<std::mutex> guard(shard.lock);
+            shard.index.clear();
+            shard.entries.clear();
+        }
+    }
+    
+    Stats stats() const {
+        return Stats{hits.load(), misses.load(), evictions.load()};
+    }
+};
+
+// How findSimilarWord finds the words within maxSuggestDistance edits
+enum class FuzzyIndex { Trie, BKTree, Deletions };
+
+// Options a dictionary snapshot is built with
+struct SpellSettings {
+    FuzzyIndex fuzzyIndex = FuzzyIndex::Trie;
+    std::string deletionIndexPath;  // where the deletion index is cached between runs ("" = never saved)
+    int maxSuggestDistance = 2;     // edit distance searched by findSimilarWord
+    double bloomFilterRate = 0.0;   // false-positive rate to size the Bloom filter for (0 = no filter)
+    size_t suggestionCacheSize = 4096;
+};
+
+// One loaded dictionary with all of its indexes. It is built once, by
+// loadDictionary or loadCompiledDictionary, and only read after that, so any
+// number of threads can query it while a SpellChecker builds its successor.
+// Its suggestion cache belongs to it and goes away with it.
+class DictionarySnapshot {
+private:
+    static constexpr uint32_t IMAGE_VERSION = 3;
+    static constexpr uint32_t BYTE_ORDER_MARK = 0x01020304;
+    
+    SpellSettings settings;
+    MappedFile image;  // compiled dictionary the indexes point into, when loaded from one
+    WordDictionary dictionary;
+    BloomFilter bloomFilter;  // empty unless enabled
+    PrefixTrie prefixTrie;
+    BKTree bkTree;
+    DeletionIndex deletionIndex;
+    mutable SuggestionCache suggestionCache;
+    
+    struct Match {
+        uint32_t id;
+        double similarity;
+    };
+    
+    std::string toLower(std::string_view str) const {
+        std::string result(str.size(), '\0');
+        foldAsciiLower(str.data(), str.size(), &result[0]);
+        return result;
+    }
+    
+    int calculateEditDistance(std::string_view word1, std::string_view word2) const {
+        return MyersPattern(word1).distance(word2);
+    }
+    
+    double calculateSimilarity(std::string_view word1, std::string_view word2) const {
+        return similarityFromDistance(word1, word2, calculateEditDistance(word1, word2));
+    }
+    
+    // Simple similarity based on edit distance and common patterns
+    static double similarityFromDistance(std::string_view word1, std::string_view word2, int editDistance) {
+        double maxLen = std::max(word1.length(), word2.length());
+        
+        if (maxLen == 0) return 1.0;
+        return 1.0 - (editDistance / maxLen);
+    }
+    
+    // Score one candidate with the similarity bonuses
+    double rankCandidate(std::string_view query, std::string_view dictWord, int distance) const {
+        double similarity = similarityFromDistance(query, dictWord, distance);
+        
+        // Bonus for same length
+        if (dictWord.length() == query.length()) {
+            similarity += 0.1;
+        }
+        
+        // Bonus for same first two letters
+        if (dictWord.substr(0, 2) == query.substr(0, 2)) {
+            similarity += 0.2;
+        }
+        
+        return similarity;
+    }
+
+public:
+    explicit DictionarySnapshot(const SpellSettings& options)
+        : settings(options), suggestionCache(options.suggestionCacheSize) {}
+    
+    DictionarySnapshot(const DictionarySnapshot&) = delete;
+    DictionarySnapshot& operator=(const DictionarySnapshot&) = delete;
+    
+    // True if path starts like a compiled image rather than a word list
+    static bool isCompiledImage(const std::string& path) {
+        std::ifstream in(path, std::ios::binary);
+        char magic[8];
+        return in.read(magic, 8) && std::string_view(magic, 8) == "SPELLIMG";
+    }
+    
+    // Status and error messages go to log
+    bool loadDictionary(const std::string& filename, std::ostream& log = std::cout) {
+        std::ifstream file(filename);
+        if (!file.is_open()) {
+            log << "Error: Could not open dictionary file '" << filename << "'" << std::endl;
+            return false;
+        }
+        
+        std::string word;
+        int wordCount = 0;
+        
+        while (std::getline(file, word)) {
+            std::string lowerWord = toLower(word);
+            
+            // Remove carriage return if present (for Windows files)
+            if (!lowerWord.empty() && lowerWord.back() == '\r') {
+                lowerWord.pop_back();
+            }
+            
+            if (!lowerWord.empty()) {
+                // Store in the arena-backed dictionary
+                dictionary.add(lowerWord);
+                wordCount++;
+            }
+        }
+        
+        dictionary.finish();
+        if (settings.bloomFilterRate > 0.0) bloomFilter.build(dictionary, settings.bloomFilterRate);
+        prefixTrie.build(dictionary);
+        file.close();
+        
+        if (settings.fuzzyIndex == FuzzyIndex::Deletions) {
+            const std::string& cachePath = settings.deletionIndexPath;
+            if (cachePath.empty() || !deletionIndex.load(cachePath, dictionary, settings.maxSuggestDistance)) {
+                deletionIndex.build(dictionary, settings.maxSuggestDistance);
+                if (!cachePath.empty()) deletionIndex.save(cachePath);
+            }
+        } else if (settings.fuzzyIndex == FuzzyIndex::BKTree) {
+            bkTree.build(dictionary);
+        }
+        log << "Dictionary loaded with " << wordCount << " words" << std::endl;
+        return true;
+    }
+    
+    // Writes the loaded dictionary and all of its indexes to a compiled image
+    bool compileDictionary(const std::string& imagePath) const {
+        ImageWriter out(imagePath);
+        if (!out.ok()) {
+            std::cout << "Error: Could not write dictionary image '" << imagePath << "'" << std::endl;
+            return false;
+        }
+        out.bytes("SPELLIMG", 8);
+        out.value(IMAGE_VERSION);
+        out.value(BYTE_ORDER_MARK);
+        out.value(static_cast<int32_t>(settings.fuzzyIndex));
+        out.value<int32_t>(settings.maxSuggestDistance);
+        dictionary.writeImage(out);
+        bloomFilter.writeImage(out);
+        prefixTrie.writeImage(out);
+        bkTree.writeImage(out);
+        deletionIndex.writeImage(out);
+        return out.ok();
+    }
+    
+    // Maps a compiled image instead of reading Dictionary.txt. Nothing is copied:
+    // the dictionary and its indexes read straight from the mapped pages. The
+    // suggestion index and distance are the ones the image was compiled with.
+    bool loadCompiledDictionary(const std::string& imagePath, std::ostream& log = std::cout) {
+        if (!image.open(imagePath)) {
+            log << "Error: Could not open dictionary image '" << imagePath << "'" << std::endl;
+            return false;
+        }
+        
+        ImageReader in(image.data(), image.size());
+        char magic[8];
+        uint32_t version = 0, byteOrder = 0;
+        int32_t savedIndex = 0, savedDistance = 0;
+        bool valid = in.bytes(magic, 8) && std::string_view(magic, 8) == "SPELLIMG"
+                  && in.value(version) && version == IMAGE_VERSION
+                  && in.value(byteOrder) && byteOrder == BYTE_ORDER_MARK
+                  && in.value(savedIndex) && savedIndex >= 0 && savedIndex <= static_cast<int32_t>(FuzzyIndex::Deletions)
+                  && in.value(savedDistance) && savedDistance >= 1 && savedDistance <= MAX_SUGGEST_DISTANCE
+                  && dictionary.readImage(in) && bloomFilter.readImage(in) && prefixTrie.readImage(in, dictionary)
+                  && bkTree.readImage(in, dictionary) && deletionIndex.readImage(in, dictionary);
+        if (!valid) {
+            log << "Error: '" << imagePath << "' is not a dictionary image for this program" << std::endl;
+            image.close();
+            return false;
+        }
+        
+        settings.fuzzyIndex = static_cast<FuzzyIndex>(savedIndex);
+        settings.maxSuggestDistance = savedDistance;
+        log << "Dictionary image loaded with " << dictionary.size() << " words" << std::endl;
+        return true;
+    }
+    
+    bool wordExists(std::string_view word) const {
+        FoldedWord lowerWord(word);
+        return lowerWordExists(lowerWord.view());
+    }
+    
+    // wordExists for a word that is already lower case, without copying it.
+    // With the Bloom filter on, most non-words are turned away before the exact lookup.
+    bool lowerWordExists(std::string_view lowerWord) const {
+        uint64_t hash = hashWord(lowerWord);
+        if (!bloomFilter.empty() && !bloomFilter.mayContain(hash)) return false;
+        return dictionary.contains(lowerWord, hash);
+    }
+    
+    // The most frequent dictionary words sharing the first two letters (at most limit),
+    // as views into the dictionary arena
+    std::vector<std::string_view> getSuggestions(std::string_view word, size_t limit = SIZE_MAX) const {
+        // Handle single character words
+        if (word.length() < 2) {
+            return {"Word too short for suggestions"};
+        }
+        
+        FoldedWord prefix(word.substr(0, 2));
+        return prefixTrie.topCompletions(prefix.view(), limit);
+    }
+    
+    // How many words getSuggestions could return without a limit
+    size_t countSuggestions(std::string_view word) const {
+        if (word.length() < 2) return 0;
+        FoldedWord prefix(word.substr(0, 2));
+        return prefixTrie.countCompletions(prefix.view());
+    }
     
-    std::string toLower(const std::string& str) {
-        std::string result = str;
-        std::transform(result.begin(), result.end(), result.begin(), ::tolower);
-        return result;
+    // Top-k completions of a prefix of any length, most frequent first
+    std::vector<std::string_view> getCompletions(std::string_view prefix, size_t k) const {
+        FoldedWord lowerPrefix(prefix);
+        return prefixTrie.topCompletions(lowerPrefix.view(), k);
+    }
+    
+    size_t countCompletions(std::string_view prefix) const {
+        FoldedWord lowerPrefix(prefix);
+        return prefixTrie.countCompletions(lowerPrefix.view());
     }
     
-    int calculateEditDistance(const std::string& word1, const std::string& word2) {
-        int m = word1.length();
-        int n = word2.length();
-        std::vector<std::vector<int>> dp(m + 1, std::vector<int>(n + 1, 0));
+    // Every dictionary word within maxSuggestDistance edits, best match first
+    // (ties go to the more common word), as views into the dictionary arena
+    std::vector<std::string_view> findSimilarWords(std::string_view misspelledWord, double minSimilarity = 0.0) const {
+        FoldedWord folded(misspelledWord);
+        std::string_view lowerMisspelled = folded.view();
+        std::vector<std::string_view> result;
         
-        for (int i = 0; i <= m; i++) dp[i][0] = i;
-        for (int j = 0; j <= n; j++) dp[0][j] = j;
+        // Handle very short words, and words too long to be near any dictionary word
+        int maxDistance = settings.maxSuggestDistance;
+        if (lowerMisspelled.length() < 2 || lowerMisspelled.length() > prefixTrie.longestWordLength() + maxDistance) {
+            return result;
+        }
         
-        for (int i = 1; i <= m; i++) {
-            for (int j = 1; j <= n; j++) {
-                if (word1[i - 1] == word2[j - 1]) {
-                    dp[i][j] = dp[i - 1][j - 1];
-                } else {
-                    dp[i][j] = 1 + std::min({dp[i - 1][j], dp[i][j - 1], dp[i - 1][j - 1]});
-                }
-            }
+        std::vector<Match> matches;
+        auto rank = [&](uint32_t id, int distance) {
+            std::string_view dictWord = dictionary.word(id);
+            if (dictWord.length() < 2) return;
+            double similarity = rankCandidate(lowerMisspelled, dictWord, distance);
+            if (similarity > minSimilarity) matches.push_back(Match{id, similarity});
+        };
+        if (settings.fuzzyIndex == FuzzyIndex::Deletions) {
+            deletionIndex.query(dictionary, lowerMisspelled, MyersPattern(lowerMisspelled), maxDistance, rank);
+        } else if (settings.fuzzyIndex == FuzzyIndex::BKTree) {
+            bkTree.query(dictionary, MyersPattern(lowerMisspelled), maxDistance, rank);
+        } else {
+            prefixTrie.fuzzyQuery(lowerMisspelled, maxDistance, rank);
         }
-        return dp[m][n];
+        
+        std::sort(matches.begin(), matches.end(), [](const Match& a, const Match& b) {
+            return a.similarity != b.similarity ? a.similarity > b.similarity : a.id < b.id;
+        });
+        result.reserve(matches.size());
+        for (const Match& match : matches) {
+            result.push_back(dictionary.word(match.id));
+        }
+        return result;
     }
     
-    double calculateSimilarity(const std::string& word1, const std::string& word2) {
-        // Simple similarity based on edit distance and common patterns
-        int editDistance = calculateEditDistance(word1, word2);
-        double maxLen = std::max(word1.length(), word2.length());
+    // Best correction for a misspelling, or "" if nothing is close enough.
+    // Answers are cached, so repeated misspellings skip the search.
+    std::string findSimilarWord(std::string_view misspelledWord) const {
+        std::string suggestion;
+        // Overlong input has no correction and is kept out of the cache
+        if (misspelledWord.length() > prefixTrie.longestWordLength() + settings.maxSuggestDistance) {
+            return suggestion;
+        }
+        FoldedWord folded(misspelledWord);
+        std::string_view lowerMisspelled = folded.view();
+        if (suggestionCache.find(lowerMisspelled, suggestion)) {
+            return suggestion;
+        }
         
-        if (maxLen == 0) return 1.0;
-        return 1.0 - (editDistance / maxLen);
+        // Only return if similarity is reasonably high
+        std::vector<std::string_view> matches = findSimilarWords(lowerMisspelled, 0.6);
+        if (!matches.empty()) {
+            suggestion = std::string(matches[0]);
+        }
+        suggestionCache.insert(lowerMisspelled, suggestion);
+        return suggestion;
+    }
+    
+    SuggestionCache::Stats suggestionCacheStats() const {
+        return suggestionCache.stats();
+    }
+    
+    // Expected false-positive rate of the Bloom filter, or 1 when there is none
+    double bloomFalsePositiveRate() const {
+        return bloomFilter.empty() ? 1.0 : bloomFilter.expectedFalsePositiveRate();
+    }
+    
+    uint32_t wordCount() const {
+        return dictionary.size();
     }
+    
+    size_t dictionaryBytes() const {
+        return dictionary.memoryBytes() + bloomFilter.memoryBytes() + prefixTrie.memoryBytes() + bkTree.memoryBytes()
+             + deletionIndex.memoryBytes();
+    }
+};
 
+// Holds the current DictionarySnapshot behind an atomically swapped pointer,
+// RCU style. Every query pins the snapshot that is current when it starts (a
+// shared_ptr copy) and finishes on it, so reload() can build the next one on
+// another thread and publish it with one pointer store without pausing
+// anybody. A replaced snapshot is freed as soon as the last query using it is
+// done. Results that point into the dictionary (string_views) are only
+// available on a pinned snapshot, so they can never outlive it.
+class SpellChecker {
+private:
+    SpellSettings settings;  // applied by the next load or reload
+    std::shared_ptr<const DictionarySnapshot> current;  // only accessed with std::atomic_load/store
+    
+    std::mutex reloaderLock;  // guards the three members below
+    std::thread reloader;
+    bool reloading = false;    // reloader has not finished yet
+    std::string reloadReport;  // messages of finished background reloads, not yet shown
+    
+    std::shared_ptr<const DictionarySnapshot> build(const std::string& path, std::ostream& log) const {
+        std::shared_ptr<DictionarySnapshot> next = std::make_shared<DictionarySnapshot>(settings);
+        bool loaded = DictionarySnapshot::isCompiledImage(path) ? next->loadCompiledDictionary(path, log)
+                                                                : next->loadDictionary(path, log);
+        return loaded ? next : nullptr;
+    }
+    
+    // Readers still holding the previous snapshot keep it alive until they finish
+    void publish(std::shared_ptr<const DictionarySnapshot> next) {
+        std::atomic_store(&current, std::move(next));
+    }
+    
 public:
-    bool loadDictionary(const std::string& filename) {
-        std::ifstream file(filename);
-        if (!file.is_open()) {
-            std::cout << "Error: Could not open dictionary file '" << filename << "'" << std::endl;
-            return false;
+    SpellChecker() = default;
+    SpellChecker(const SpellChecker&) = delete;
+    SpellChecker& operator=(const SpellChecker&) = delete;
+    
+    ~SpellChecker() {
+        std::thread running;
+        {
+            std::lock_guard<std::mutex> guard(reloaderLock);
+            running.swap(reloader);
         }
+        if (running.joinable()) running.join();  // the thread takes reloaderLock before it ends
+    }
+    
+    // The dictionary queries run against right now. Holding on to it keeps it
+    // (and every view into it) alive across reloads; getSuggestions,
+    // getCompletions and findSimilarWords are called on it.
+    std::shared_ptr<const DictionarySnapshot> snapshot() const {
+        return std::atomic_load(&current);
+    }
+    
+    // Loads a word list, or a compiled image when path is one, and makes it current
+    bool loadDictionary(const std::string& path, std::ostream& log = std::cout) {
+        std::shared_ptr<const DictionarySnapshot> next = build(path, log);
+        if (!next) return false;
+        publish(std::move(next));
+        return true;
+    }
+    
+    bool loadCompiledDictionary(const std::string& imagePath) {
+        std::shared_ptr<DictionarySnapshot> next = std::make_shared<DictionarySnapshot>(settings);
+        if (!next->loadCompiledDictionary(imagePath)) return false;
+        publish(std::move(next));
+        return true;
+    }
+    
+    // Builds a new snapshot from path and swaps it in; queries keep running on
+    // the old one meanwhile. On failure the old snapshot stays current.
+    bool reload(const std::string& path, std::ostream& log = std::cout) {
+        return loadDictionary(path, log);
+    }
+    
+    // reload() on a background thread. Returns false right away if the previous
+    // background reload is still running. Its messages are collected for
+    // takeReloadReport() instead of being printed over the caller's output.
+    bool reloadInBackground(const std::string& path) {
+        std::lock_guard<std::mutex> guard(reloaderLock);
+        if (reloading) return false;
+        if (reloader.joinable()) reloader.join();  // finished, only needs reaping
+        reloading = true;
+        reloader = std::thread([this, path]() {
+            std::ostringstream log;
+            if (!reload(path, log)) log << "Reload failed, still using the previous dictionary" << std::endl;
+            std::lock_guard<std::mutex> guard(reloaderLock);
+            reloadReport += log.str();
+            reloading = false;
+        });
+        return true;
+    }
+    
+    // Messages of the background reloads that finished since the last call ("" if none)
+    std::string takeReloadReport() {
+        std::lock_guard<std::mutex> guard(reloaderLock);
+        std::string report;
+        report.swap(reloadReport);
+        return report;
+    }
+    
+    bool compileDictionary(const std::string& imagePath) const {
+        return snapshot()->compileDictionary(imagePath);
+    }
+    
+    bool wordExists(std::string_view word) const {
+        return snapshot()->wordExists(word);
+    }
+    
+    bool lowerWordExists(std::string_view lowerWord) const {
+        return snapshot()->lowerWordExists(lowerWord);
+    }
+    
+    size_t countSuggestions(std::string_view word) const {
+        return snapshot()->countSuggestions(word);
+    }
+    
+    size_t countCompletions(std::string_view prefix) const {
+        return snapshot()->countCompletions(prefix);
+    }
+    
+    std::string findSimilarWord(std::string_view misspelledWord) const {
+        return snapshot()->findSimilarWord(misspelledWord);
+    }
+    
+    // How many findSimilarWord results each snapshot caches (0 turns caching off;
+    // set before loadDictionary)
+    void setSuggestionCacheSize(size_t entries) {
+        settings.suggestionCacheSize = entries;
+    }
+    
+    // Cache statistics of the current snapshot (they restart with every reload)
+    SuggestionCache::Stats suggestionCacheStats() const {
+        return snapshot()->suggestionCacheStats();
+    }
+    
+    // Largest edit distance findSimilarWord will correct (set before loadDictionary)
+    void setMaxSuggestDistance(int distance) {
+        settings.maxSuggestDistance = std::min(std::max(1, distance), MAX_SUGGEST_DISTANCE);
+    }
+    
+    // Reject non-words with a Bloom filter sized for the given false-positive rate
+    // before the exact lookup (set before loadDictionary; 0 turns it off)
+    void enableBloomFilter(double falsePositiveRate = 0.01) {
+        settings.bloomFilterRate = std::max(0.0, std::min(falsePositiveRate, 1.0));
+    }
+    
+    double bloomFalsePositiveRate() const {
+        return snapshot()->bloomFalsePositiveRate();
+    }
+    
+    // Search a BK-tree instead of walking the trie (set before loadDictionary)
+    void enableBKTree() {
+        settings.fuzzyIndex = FuzzyIndex::BKTree;
+    }
+    
+    // Use the precomputed deletion index instead of walking the trie (set before loadDictionary).
+    // With a cache path the index is loaded from there when it matches the dictionary,
+    // otherwise it is built and saved there for the next start.
+    void enableDeletionIndex(const std::string& cachePath = "") {
+        settings.fuzzyIndex = FuzzyIndex::Deletions;
+        settings.deletionIndexPath = cachePath;
+    }
+    
+    size_t dictionaryBytes() const {
+        return snapshot()->dictionaryBytes();
+    }
+};
+
+// ===================== BATCH CHECKING =====================
+// Checks a whole document: the file is memory-mapped and cut into chunks at
+// word boundaries, worker threads tokenize their chunks and look every word
+// up in the shared read-only dictionary, and only the distinct misspellings
+// are sent through the (much slower) suggestion search. Words are runs of
+// ASCII letters and are checked case-insensitively.
+
+struct Misspelling {
+    uint64_t offset;    // byte offset of the word in the input
+    uint32_t length;
+    uint32_t distinct;  // index into the distinct misspelled words
+};
+
+struct BatchResult {
+    uint64_t bytes = 0;
+    uint64_t words = 0;
+    uint64_t misspellings = 0;
+    uint64_t distinctMisspellings = 0;
+    double seconds = 0.0;
+};
+
+inline bool isWordByte(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+// Finds the misspelled words in text[begin, end), appending them to out; returns the number of words seen
+inline uint64_t checkChunk(const DictionarySnapshot& dictionary, const char* text, size_t begin, size_t end,
+                           std::vector<Misspelling>& out) {
+    std::string lower;
+    uint64_t words = 0;
+    size_t i = begin;
+    
+    while (i < end) {
+        while (i < end && !isWordByte(text[i])) i++;
+        size_t start = i;
+        while (i < end && isWordByte(text[i])) i++;
+        if (start == i) break;
         
-        std::string word;
-        int wordCount = 0;
+        lower.resize(i - start);
+        foldAsciiLower(text + start, i - start, &lower[0]);
+        words++;
+        if (!dictionary.lowerWordExists(lower)) {
+            out.push_back(Misspelling{start, static_cast<uint32_t>(i - start), 0});
+        }
+    }
+    return words;
+}
+
+// Writes "offset<TAB>word<TAB>suggestion" for every misspelled word of inputPath to outputPath.
+// Returns false (with result untouched) when either file cannot be opened. The whole
+// document is checked against the snapshot that is current when it starts.
+bool checkDocument(const SpellChecker& checker, const std::string& inputPath, const std::string& outputPath,
+                   int threads, BatchResult& result) {
+    auto startTime = std::chrono::steady_clock::now();
+    std::shared_ptr<const DictionarySnapshot> dictionary = checker.snapshot();
+    MappedFile input;
+    if (!input.open(inputPath)) {
+        std::cout << "Error: Could not open input file '" << inputPath << "'" << std::endl;
+        return false;
+    }
+    std::ofstream output(outputPath, std::ios::binary);
+    if (!output.is_open()) {
+        std::cout << "Error: Could not open output file '" << outputPath << "'" << std::endl;
+        return false;
+    }
+    
+    // Several chunks per thread so a slow chunk does not hold everyone up;
+    // every boundary is pushed forward until it no longer splits a word
+    const char* text = input.data();
+    const size_t size = input.size();
+    const size_t MIN_CHUNK = 1 << 20;
+    size_t chunkCount = std::max<size_t>(1, std::min<size_t>(static_cast<size_t>(threads) * 8, size / MIN_CHUNK));
+    std::vector<size_t> bounds(chunkCount + 1, size);
+    bounds[0] = 0;
+    for (size_t c = 1; c < chunkCount; c++) {
+        size_t b = std::max(bounds[c - 1], size / chunkCount * c);
+        while (b < size && b > 0 && isWordByte(text[b]) && isWordByte(text[b - 1])) b++;
+        bounds[c] = b;
+    }
+    
+    std::vector<std::vector<Misspelling>> found(chunkCount);
+    std::vector<uint64_t> wordCounts(chunkCount, 0);
+    std::atomic<size_t> nextChunk(0);
+    parallelFor(threads, [&](int) {
+        for (size_t c = nextChunk++; c < chunkCount; c = nextChunk++) {
+            wordCounts[c] = checkChunk(*dictionary, text, bounds[c], bounds[c + 1], found[c]);
+        }
+    });
+    
+    // Deduplicate (case-insensitively) so each distinct misspelling is searched once
+    std::unordered_map<std::string, uint32_t> distinctIds;
+    std::vector<std::string> distinctWords;
+    for (auto& chunk : found) {
+        for (Misspelling& miss : chunk) {
+            std::string lower(miss.length, '\0');
+            foldAsciiLower(text + miss.offset, miss.length, &lower[0]);
+            auto inserted = distinctIds.emplace(lower, static_cast<uint32_t>(distinctWords.size()));
+            if (inserted.second) distinctWords.push_back(lower);
+            miss.distinct = inserted.first->second;
+        }
+    }
+    
+    std::vector<std::string> suggestions(distinctWords.size());
+    std::atomic<size_t> nextWord(0);
+    parallelFor(threads, [&](int) {
+        for (size_t w = nextWord++; w < distinctWords.size(); w = nextWord++) {
+            suggestions[w] = dictionary->findSimilarWord(distinctWords[w]);
+        }
+    });
+    
+    // Chunks are in file order, and so are the misspellings inside each of them
+    for (size_t c = 0; c < chunkCount; c++) {
+        for (const Misspelling& miss : found[c]) {
+            output << miss.offset << '\t';
+            output.write(text + miss.offset, miss.length);
+            output << '\t' << suggestions[miss.distinct] << '\n';
+            result.misspellings++;
+        }
+        result.words += wordCounts[c];
+    }
+    
+    result.bytes = size;
+    result.distinctMisspellings = distinctWords.size();
+    result.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return static_cast<bool>(output);
+}
+
+// ===================== QUERY SERVER =====================
+
+// Server mode keeps one dictionary loaded for many clients on a Unix domain socket.
+// Every frame, in both directions, is a native-endian uint32 payload length followed
+// by the payload. A request payload is one command byte followed by one or more
+// words separated by '\n'; the response has one line per word, in the same order:
+//   'E' exists:  "1" or "0"
+//   'C' correct: the best correction, or an empty line
+//   'S' suggest: the most common words sharing the first two letters, comma separated
+// Clients may pipeline any number of requests; responses come back in request order.
+#ifdef __linux__
+
+const uint32_t MAX_FRAME_BYTES = 1 << 20;
+
+inline void appendFrameHeader(std::string& out, uint32_t length) {
+    char header[4];
+    std::memcpy(header, &length, 4);
+    out.append(header, 4);
+}
+
+// Bytes in buffer that form complete frames (0 if none); false if a frame is too large
+inline bool completeFrames(const std::string& buffer, size_t& bytes) {
+    bytes = 0;
+    while (buffer.size() - bytes >= 4) {
+        uint32_t length;
+        std::memcpy(&length, buffer.data() + bytes, 4);
+        if (length > MAX_FRAME_BYTES) return false;
+        if (buffer.size() - bytes - 4 < length) break;
+        bytes += 4 + length;
+    }
+    return true;
+}
+
+// Answers every request frame in requests, appending the response frames to out
+inline void answerFrames(const DictionarySnapshot& dictionary, std::string_view requests, size_t suggestionLimit,
+                         std::string& out) {
+    while (requests.size() >= 4) {
+        uint32_t length;
+        std::memcpy(&length, requests.data(), 4);
+        std::string_view payload = requests.substr(4, length);
+        requests.remove_prefix(4 + length);
         
-        while (std::getline(file, word)) {
-            std::string lowerWord = toLower(word);
-            
-            // Remove carriage return if present (for Windows files)
-            if (!lowerWord.empty() && lowerWord.back() == '\r') {
-                lowerWord.pop_back();
-            }
+        size_t header = out.size();
+        appendFrameHeader(out, 0);
+        char command = payload.empty() ? '\0' : payload[0];
+        std::string_view words = payload.substr(payload.empty() ? 0 : 1);
+        if (command != 'E' && command != 'C' && command != 'S') {
+            out += "ERR unknown command";
+            words = {};
+        }
+        
+        bool first = true;
+        while (!words.empty() || first) {
+            size_t end = std::min(words.find('\n'), words.size());
+            std::string_view word = words.substr(0, end);
+            words.remove_prefix(std::min(end + 1, words.size()));
+            if (!first) out += '\n';
+            first = false;
             
-            if (!lowerWord.empty()) {
-                // Store in main dictionary
-                dictionary[lowerWord] = true;
-                
-                // Store in prefix map for suggestions (only if word has at least 2 chars)
-                if (lowerWord.length() >= 2) {
-                    std::string prefix = lowerWord.substr(0, 2);
-                    prefixMap[prefix].push_back(lowerWord);
+            if (command == 'E') {
+                out += dictionary.wordExists(word) ? '1' : '0';
+            } else if (command == 'C') {
+                out += dictionary.findSimilarWord(word);
+            } else if (command == 'S' && word.length() >= 2) {
+                std::vector<std::string_view> suggestions = dictionary.getSuggestions(word, suggestionLimit);
+                for (size_t i = 0; i < suggestions.size(); i++) {
+                    if (i > 0) out += ',';
+                    out += suggestions[i];
                 }
-                wordCount++;
             }
         }
+        uint32_t responseLength = static_cast<uint32_t>(out.size() - header - 4);
+        std::memcpy(&out[header], &responseLength, 4);
+    }
+}
+
+// epoll event loop plus a worker pool. The loop does all socket I/O; everything
+// one connection has sent is handed to a worker as a single batch, answered
+// against one pinned dictionary snapshot, and the next batch from that
+// connection is only dispatched once the previous one is back, so responses
+// stay in order without any per-request bookkeeping.
+class QueryServer {
+private:
+    static constexpr uint64_t LISTEN_ID = 0;
+    static constexpr uint64_t WAKE_ID = 1;
+    static const size_t MAX_BUFFERED = 4 << 20;  // stop reading from (or answering) a client this far behind
+    
+    struct Connection {
+        int fd = -1;
+        std::string in;     // received, not yet handed to a worker
+        std::string out;    // answered, not yet written
+        size_t written = 0;
+        bool busy = false;  // a batch is with the workers
+        bool hungUp = false;
+        uint32_t events = 0;  // what the fd is registered for, 0 = not in the epoll set
+    };
+    
+    struct Batch {
+        uint64_t connection;
+        std::string data;  // request frames going in, response frames coming back
+    };
+    
+    const SpellChecker& checker;
+    int workerCount;
+    size_t suggestionLimit;
+    int epollFd = -1;
+    int listenFd = -1;
+    int wakeFd = -1;  // eventfd: workers finished a batch, or stop() was called
+    std::atomic<bool> stopping{false};
+    
+    std::unordered_map<uint64_t, Connection> connections;
+    uint64_t nextId = WAKE_ID + 1;
+    
+    std::mutex queueLock;
+    std::condition_variable queueReady;
+    std::deque<Batch> pending;   // waiting for a worker
+    std::vector<Batch> finished; // waiting for the event loop
+    bool workersDone = false;
+    
+    void wake() {
+        uint64_t one = 1;
+        ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+        (void)ignored;
+    }
+    
+    void work() {
+        std::string answer;
+        while (true) {
+            Batch batch;
+            {
+                std::unique_lock<std::mutex> guard(queueLock);
+                queueReady.wait(guard, [this] { return workersDone || !pending.empty(); });
+                if (pending.empty()) return;
+                batch = std::move(pending.front());
+                pending.pop_front();
+            }
+            answer.clear();
+            answerFrames(*checker.snapshot(), batch.data, suggestionLimit, answer);
+            batch.data.swap(answer);
+            {
+                std::lock_guard<std::mutex> guard(queueLock);
+                finished.push_back(std::move(batch));
+            }
+            wake();
+        }
+    }
+    
+    void watch(uint64_t id, Connection& conn) {
+        size_t unsent = conn.out.size() - conn.written;
+        uint32_t events = 0;
+        if (!conn.hungUp && conn.in.size() < MAX_BUFFERED) events |= EPOLLIN;
+        if (unsent > 0) events |= EPOLLOUT;
+        if (events == conn.events) return;
+        // EPOLLHUP is reported even when no events are requested, so a connection
+        // with nothing to wait for (a closed client whose batch is still out)
+        // leaves the interest set instead of waking the loop over and over
+        epoll_event event{};
+        event.events = events;
+        event.data.u64 = id;
+        int op = events == 0 ? EPOLL_CTL_DEL : conn.events == 0 ? EPOLL_CTL_ADD : EPOLL_CTL_MOD;
+        epoll_ctl(epollFd, op, conn.fd, &event);
+        conn.events = events;
+    }
+    
+    void close(uint64_t id) {
+        auto found = connections.find(id);
+        if (found == connections.end()) return;
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, found->second.fd, nullptr);
+        ::close(found->second.fd);
+        connections.erase(found);
+    }
+    
+    // Hands the complete frames received so far to the workers, unless a batch is already out
+    bool dispatch(uint64_t id, Connection& conn) {
+        if (conn.busy || conn.out.size() - conn.written >= MAX_BUFFERED) return true;
+        size_t bytes;
+        if (!completeFrames(conn.in, bytes)) return false;
+        if (bytes == 0) return true;
         
-        file.close();
-        std::cout << "Dictionary loaded with " << wordCount << " words" << std::endl;
+        Batch batch{id, conn.in.substr(0, bytes)};
+        conn.in.erase(0, bytes);
+        conn.busy = true;
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            pending.push_back(std::move(batch));
+        }
+        queueReady.notify_one();
+        return true;
+    }
+    
+    // Writes as much of the answered data as the socket takes; false on a dead connection
+    bool flush(Connection& conn) {
+        while (conn.written < conn.out.size()) {
+            ssize_t n = ::send(conn.fd, conn.out.data() + conn.written, conn.out.size() - conn.written, MSG_NOSIGNAL);
+            if (n < 0) return errno == EAGAIN || errno == EWOULDBLOCK;
+            conn.written += static_cast<size_t>(n);
+        }
+        conn.out.clear();
+        conn.written = 0;
         return true;
     }
     
-    bool wordExists(const std::string& word) {
-        return dictionary.find(toLower(word)) != dictionary.end();
+    // Picks up after any event on a connection: answer, write, and close once a hung-up client is served
+    void update(uint64_t id) {
+        auto found = connections.find(id);
+        if (found == connections.end()) return;
+        Connection& conn = found->second;
+        if (!flush(conn) || !dispatch(id, conn)) {
+            close(id);
+            return;
+        }
+        if (conn.hungUp && !conn.busy && conn.out.empty()) {
+            close(id);
+            return;
+        }
+        watch(id, conn);
+    }
+    
+    void accept() {
+        while (true) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) return;
+            uint64_t id = nextId++;
+            Connection& conn = connections[id];
+            conn.fd = fd;
+            conn.events = EPOLLIN;
+            epoll_event event{};
+            event.events = EPOLLIN;
+            event.data.u64 = id;
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+        }
+    }
+    
+    void receive(uint64_t id) {
+        auto found = connections.find(id);
+        if (found == connections.end()) return;
+        Connection& conn = found->second;
+        char buffer[64 * 1024];
+        while (conn.in.size() < MAX_BUFFERED) {
+            ssize_t n = ::recv(conn.fd, buffer, sizeof(buffer), 0);
+            if (n > 0) {
+                conn.in.append(buffer, static_cast<size_t>(n));
+            } else if (n == 0) {
+                conn.hungUp = true;
+                break;
+            } else if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                break;
+            } else {
+                close(id);
+                return;
+            }
+        }
+        update(id);
+    }
+    
+    void collectFinished() {
+        uint64_t count;
+        ssize_t ignored = ::read(wakeFd, &count, sizeof(count));
+        (void)ignored;
+        std::vector<Batch> done;
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            done.swap(finished);
+        }
+        for (Batch& batch : done) {
+            auto found = connections.find(batch.connection);
+            if (found == connections.end()) continue;  // client left while its batch was out
+            found->second.busy = false;
+            found->second.out += batch.data;
+            update(batch.connection);
+        }
+    }
+    
+    void cleanUp() {
+        for (auto& entry : connections) ::close(entry.second.fd);
+        connections.clear();
+        if (listenFd >= 0) ::close(listenFd);
+        if (wakeFd >= 0) ::close(wakeFd);
+        if (epollFd >= 0) ::close(epollFd);
+        listenFd = wakeFd = epollFd = -1;
+    }
+
+public:
+    QueryServer(const SpellChecker& spellChecker, int workers, size_t limit = 10)
+        : checker(spellChecker), workerCount(std::max(1, workers)), suggestionLimit(limit) {}
+    
+    ~QueryServer() {
+        cleanUp();
     }
     
-    std::vector<std::string> getSuggestions(const std::string& word) {
-        std::string lowerWord = toLower(word);
+    // Serves socketPath until stop() is called; false if the socket cannot be set up
+    bool run(const std::string& socketPath) {
+        sockaddr_un address{};
+        if (socketPath.size() >= sizeof(address.sun_path)) {
+            std::cout << "Error: socket path '" << socketPath << "' is too long" << std::endl;
+            return false;
+        }
+        address.sun_family = AF_UNIX;
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+        ::unlink(socketPath.c_str());
         
-        // Handle single character words
-        if (lowerWord.length() < 2) {
-            return {"Word too short for suggestions"};
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+        wakeFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (listenFd < 0 || epollFd < 0 || wakeFd < 0
+            || ::bind(listenFd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0
+            || ::listen(listenFd, SOMAXCONN) < 0) {
+            std::cout << "Error: Could not listen on '" << socketPath << "': " << std::strerror(errno) << std::endl;
+            cleanUp();
+            return false;
+        }
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = LISTEN_ID;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+        event.data.u64 = WAKE_ID;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, wakeFd, &event);
+        
+        workersDone = false;
+        std::vector<std::thread> workers;
+        for (int t = 0; t < workerCount; t++) {
+            workers.emplace_back([this] { work(); });
         }
         
-        std::string prefix = lowerWord.substr(0, 2);
-        auto it = prefixMap.find(prefix);
-        if (it != prefixMap.end()) {
-            return it->second;
+        std::cout << "Serving on " << socketPath << " with " << workerCount << " workers" << std::endl;
+        epoll_event events[64];
+        while (!stopping) {
+            int ready = ::epoll_wait(epollFd, events, 64, -1);
+            if (ready < 0 && errno != EINTR) break;
+            for (int e = 0; e < ready; e++) {
+                uint64_t id = events[e].data.u64;
+                if (id == LISTEN_ID) {
+                    accept();
+                } else if (id == WAKE_ID) {
+                    collectFinished();
+                } else if (events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                    receive(id);
+                } else {
+                    update(id);
+                }
+            }
         }
         
-        return {};
+        {
+            std::lock_guard<std::mutex> guard(queueLock);
+            workersDone = true;
+            pending.clear();
+        }
+        queueReady.notify_all();
+        for (std::thread& worker : workers) worker.join();
+        finished.clear();
+        cleanUp();
+        ::unlink(socketPath.c_str());
+        return true;
     }
     
-    std::string findSimilarWord(const std::string& misspelledWord) {
-        std::string lowerMisspelled = toLower(misspelledWord);
-        
-        // Handle very short words
-        if (lowerMisspelled.length() < 2) {
-            return "";
+    // Makes run() return; safe to call from any thread or a signal handler
+    void stop() {
+        stopping = true;
+        if (wakeFd >= 0) wake();
+    }
+};
+
+// Load generator: each connection keeps `depth` single-word requests in flight
+// (80% exists, 10% correct, 10% suggest, half of them misspelled) until time
+// runs out, then the overall rate and latency percentiles are printed
+bool runLoadGenerator(const std::string& socketPath, const std::string& wordFile, int connectionCount,
+                      double seconds, int depth) {
+    std::vector<std::string> words;
+    std::ifstream file(wordFile);
+    std::string line;
+    while (words.size() < 100000 && std::getline(file, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.size() >= 2) words.push_back(line);
+    }
+    if (words.empty()) {
+        std::cout << "Error: Could not read sample words from '" << wordFile << "'" << std::endl;
+        return false;
+    }
+    
+    sockaddr_un address{};
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        std::cout << "Error: socket path '" << socketPath << "' is too long" << std::endl;
+        return false;
+    }
+    address.sun_family = AF_UNIX;
+    std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+    
+    std::vector<std::vector<uint32_t>> latencies(connectionCount);  // microseconds, per connection
+    std::atomic<int> failures(0);
+    auto startTime = std::chrono::steady_clock::now();
+    auto deadline = startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(seconds));
+    
+    parallelFor(connectionCount, [&](int c) {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0 || ::connect(fd, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0) {
+            failures++;
+            if (fd >= 0) ::close(fd);
+            return;
         }
         
-        char firstLetter = lowerMisspelled[0];
-        std::string bestMatch;
-        double bestSimilarity = 0.0;
-        
-        // Check all words starting with the same first letter
-        for (const auto& entry : dictionary) {
-            const std::string& dictWord = entry.first;
+        uint64_t state = 0x9E3779B97F4A7C15ull * (c + 1);
+        std::string request, received;
+        std::vector<std::chrono::steady_clock::time_point> sentAt(depth);
+        char buffer[64 * 1024];
+        bool alive = true;
+        while (alive && std::chrono::steady_clock::now() < deadline) {
+            request.clear();
+            for (int r = 0; r < depth; r++) {
+                state = state * 6364136223846793005ull + 1442695040888963407ull;
+                uint32_t pick = static_cast<uint32_t>(state >> 33);
+                std::string word = words[pick % words.size()];
+                if (pick & 0x100) word[word.size() / 2] = 'q';
+                char command = (pick >> 24) % 10 < 8 ? 'E' : ((pick >> 24) % 10 == 8 ? 'C' : 'S');
+                appendFrameHeader(request, static_cast<uint32_t>(word.size() + 1));
+                request += command;
+                request += word;
+            }
             
-            if (dictWord.length() >= 2 && dictWord[0] == firstLetter) {
-                double similarity = calculateSimilarity(lowerMisspelled, dictWord);
-                
-                // Bonus for same length
-                if (dictWord.length() == lowerMisspelled.length()) {
-                    similarity += 0.1;
+            auto now = std::chrono::steady_clock::now();
+            std::fill(sentAt.begin(), sentAt.end(), now);
+            for (size_t sent = 0; sent < request.size();) {
+                ssize_t n = ::send(fd, request.data() + sent, request.size() - sent, MSG_NOSIGNAL);
+                if (n <= 0) {
+                    alive = false;
+                    break;
                 }
-                
-                // Bonus for same first two letters
-                if (dictWord.length() >= 2 && lowerMisspelled.length() >= 2 && 
-                    dictWord.substr(0, 2) == lowerMisspelled.substr(0, 2)) {
-                    similarity += 0.2;
+                sent += static_cast<size_t>(n);
+            }
+            
+            int answered = 0;
+            received.clear();
+            while (alive && answered < depth) {
+                ssize_t n = ::recv(fd, buffer, sizeof(buffer), 0);
+                if (n <= 0) {
+                    alive = false;
+                    break;
                 }
-                
-                if (similarity > bestSimilarity) {
-                    bestSimilarity = similarity;
-                    bestMatch = dictWord;
+                received.append(buffer, static_cast<size_t>(n));
+                size_t bytes;
+                completeFrames(received, bytes);
+                // Count the frames that just completed and timestamp them
+                size_t offset = 0;
+                auto arrived = std::chrono::steady_clock::now();
+                while (offset < bytes) {
+                    uint32_t length;
+                    std::memcpy(&length, received.data() + offset, 4);
+                    offset += 4 + length;
+                    latencies[c].push_back(static_cast<uint32_t>(
+                        std::chrono::duration_cast<std::chrono::microseconds>(arrived - sentAt[answered]).count()));
+                    answered++;
                 }
+                received.erase(0, bytes);
             }
         }
-        
-        // Only return if similarity is reasonably high
-        if (bestSimilarity > 0.6) {
-            return bestMatch;
-        }
-        
-        return "";
+        if (!alive) failures++;
+        ::close(fd);
+    });
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    
+    std::vector<uint32_t> all;
+    for (auto& connection : latencies) all.insert(all.end(), connection.begin(), connection.end());
+    if (all.empty()) {
+        std::cout << "Error: no responses from '" << socketPath << "'" << std::endl;
+        return false;
     }
-};
+    std::sort(all.begin(), all.end());
+    auto percentile = [&](double p) { return all[std::min(all.size() - 1, static_cast<size_t>(p * all.size()))]; };
+    std::cout << all.size() << " requests over " << connectionCount << " connections (depth " << depth << ") in "
+              << elapsed << " s: " << static_cast<uint64_t>(all.size() / elapsed) << " QPS, latency p50 "
+              << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, max " << all.back() << " us" << std::endl;
+    if (failures > 0) std::cout << failures << " connections failed" << std::endl;
+    return true;
+}
+
+// Ctrl+C / kill end server mode cleanly (socket file removed)
+QueryServer* runningServer = nullptr;
+
+void stopServer(int) {
+    if (runningServer) runningServer->stop();
+}
+
+#endif
 
 // Function to get user input with prompt
 std::string getInput(const std::string& prompt) {
@@ -159,8 +2605,8 @@ std::string getInput(const std::string& prompt) {
     return input;
 }
 
-// Function to display suggestions
-void displaySuggestions(const std::vector<std::string>& suggestions) {
+// Function to display suggestions (total = how many exist, suggestions may be the first few)
+void displaySuggestions(const std::vector<std::string_view>& suggestions, size_t total) {
     if (suggestions.empty()) {
         std::cout << "No suggestions available" << std::endl;
         return;
@@ -172,60 +2618,186 @@ void displaySuggestions(const std::vector<std::string>& suggestions) {
     }
     
     std::cout << "Suggestions: ";
-    int count = 0;
-    for (const auto& word : suggestions) {
-        if (count >= 10) { // Limit to 10 suggestions
-            std::cout << "... and " << (suggestions.size() - 10) << " more";
-            break;
-        }
-        std::cout << word;
-        if (count < std::min(10, (int)suggestions.size() - 1)) {
+    for (size_t i = 0; i < suggestions.size(); i++) {
+        std::cout << suggestions[i];
+        if (i + 1 < suggestions.size() || total > suggestions.size()) {
             std::cout << ", ";
         }
-        count++;
+    }
+    if (total > suggestions.size()) {
+        std::cout << "... and " << (total - suggestions.size()) << " more";
     }
     std::cout << std::endl;
 }
 
-int main() {
+const size_t SUGGESTION_LIMIT = 10;
+
+int main(int argc, char* argv[]) {
     SpellChecker spellChecker;
     
+    // hashingDict.exe --deletion-index: fast suggestions, index cached in Dictionary.symdel
+    // hashingDict.exe --bk-tree: search a BK-tree instead of the dictionary trie
+    // hashingDict.exe --bloom [rate]: Bloom filter in front of lookups (default 1% false positives)
+    // hashingDict.exe --check input.txt output.tsv [threads]: batch-check a document and exit
+    // hashingDict.exe --compile Dictionary.img: load Dictionary.txt, write a compiled image and exit
+    // hashingDict.exe --image Dictionary.img: start from a compiled image instead of Dictionary.txt
+    // hashingDict --serve spell.sock [threads]: answer queries on a Unix domain socket (Linux)
+    // hashingDict --bench-client spell.sock [connections] [seconds] [depth]: load-test a running server
+    std::string checkInput, checkOutput, compilePath, imagePath, servePath, benchPath;
+    int checkThreads = defaultThreadCount();
+    int serveThreads = defaultThreadCount();
+    int benchConnections = 4, benchDepth = 16;
+    double benchSeconds = 5.0;
+    for (int i = 1; i < argc; i++) {
+        if (std::string(argv[i]) == "--deletion-index") {
+            spellChecker.enableDeletionIndex("Dictionary.symdel");
+        } else if (std::string(argv[i]) == "--bk-tree") {
+            spellChecker.enableBKTree();
+        } else if (std::string(argv[i]) == "--bloom") {
+            bool rateGiven = i + 1 < argc && (std::isdigit(static_cast<unsigned char>(argv[i + 1][0])) || argv[i + 1][0] == '.');
+            spellChecker.enableBloomFilter(rateGiven ? std::atof(argv[++i]) : 0.01);
+        } else if (std::string(argv[i]) == "--compile" && i + 1 < argc) {
+            compilePath = argv[++i];
+        } else if (std::string(argv[i]) == "--image" && i + 1 < argc) {
+            imagePath = argv[++i];
+        } else if (std::string(argv[i]) == "--check" && i + 2 < argc) {
+            checkInput = argv[++i];
+            checkOutput = argv[++i];
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                checkThreads = std::max(1, std::atoi(argv[++i]));
+            }
+        } else if (std::string(argv[i]) == "--serve" && i + 1 < argc) {
+            servePath = argv[++i];
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                serveThreads = std::max(1, std::atoi(argv[++i]));
+            }
+        } else if (std::string(argv[i]) == "--bench-client" && i + 1 < argc) {
+            benchPath = argv[++i];
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                benchConnections = std::max(1, std::atoi(argv[++i]));
+            }
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                benchSeconds = std::max(0.1, std::atof(argv[++i]));
+            }
+            if (i + 1 < argc && std::isdigit(static_cast<unsigned char>(argv[i + 1][0]))) {
+                benchDepth = std::max(1, std::atoi(argv[++i]));
+            }
+        }
+    }
+    
+    if (!benchPath.empty() || !servePath.empty()) {
+#ifndef __linux__
+        std::cout << "Error: --serve and --bench-client need Linux (Unix domain sockets and epoll)" << std::endl;
+        return 1;
+#else
+        // The client only needs sample words, not a loaded dictionary
+        if (!benchPath.empty()) {
+            return runLoadGenerator(benchPath, "Dictionary.txt", benchConnections, benchSeconds, benchDepth) ? 0 : 1;
+        }
+#endif
+    }
+    
     std::cout << "=== Spell Checker and Word Suggestion Program ===" << std::endl;
     std::cout << "Loading dictionary..." << std::endl;
     
-    if (!spellChecker.loadDictionary("Dictionary.txt")) {
+    if (!imagePath.empty()) {
+        if (!spellChecker.loadCompiledDictionary(imagePath)) {
+            return 1;
+        }
+    } else if (!spellChecker.loadDictionary("Dictionary.txt")) {
         std::cout << "Failed to load dictionary. Please make sure 'Dictionary.txt' exists." << std::endl;
         return 1;
     }
     
-    std::cout << "\nType 'quit' to exit the program\n" << std::endl;
+    if (!compilePath.empty()) {
+        if (!spellChecker.compileDictionary(compilePath)) {
+            return 1;
+        }
+        std::cout << "Compiled dictionary image written to " << compilePath << std::endl;
+        return 0;
+    }
+    
+    if (!checkInput.empty()) {
+        BatchResult result;
+        if (!checkDocument(spellChecker, checkInput, checkOutput, checkThreads, result)) {
+            return 1;
+        }
+        std::cout << "Checked " << result.words << " words (" << result.bytes << " bytes) with "
+                  << checkThreads << " threads in " << result.seconds << " s, "
+                  << (result.bytes / 1e6 / std::max(result.seconds, 1e-9)) << " MB/s" << std::endl;
+        std::cout << result.misspellings << " misspellings (" << result.distinctMisspellings
+                  << " distinct) written to " << checkOutput << std::endl;
+        return 0;
+    }
+    
+#ifdef __linux__
+    if (!servePath.empty()) {
+        QueryServer server(spellChecker, serveThreads, SUGGESTION_LIMIT);
+        runningServer = &server;
+        std::signal(SIGINT, stopServer);
+        std::signal(SIGTERM, stopServer);
+        bool served = server.run(servePath);
+        runningServer = nullptr;
+        return served ? 0 : 1;
+    }
+#endif
+    
+    std::cout << "\nType 'quit' to exit the program, 'reload' to re-read the dictionary,"
+              << " end a word with * to complete it\n" << std::endl;
     
     while (true) {
+        std::cout << spellChecker.takeReloadReport();  // background reloads report here, between prompts
         std::string userInput = getInput("Please enter a word: ");
         
         // Check for exit condition
         if (userInput == "quit") {
+            SuggestionCache::Stats cache = spellChecker.suggestionCacheStats();
+            if (cache.hits + cache.misses > 0) {
+                std::cout << "Suggestion cache: " << cache.hits << " of " << (cache.hits + cache.misses)
+                          << " lookups answered (" << (cache.hitRate() * 100) << "%)" << std::endl;
+            }
             std::cout << "Goodbye!" << std::endl;
             break;
         }
         
+        // Re-read the dictionary in the background; lookups keep using the old one until it is ready
+        if (userInput == "reload") {
+            if (spellChecker.reloadInBackground(imagePath.empty() ? "Dictionary.txt" : imagePath)) {
+                std::cout << "Reloading dictionary..." << std::endl << std::endl;
+            } else {
+                std::cout << "A reload is already in progress." << std::endl << std::endl;
+            }
+            continue;
+        }
+        
         // Handle empty input
         if (userInput.empty()) {
             std::cout << "Please enter a valid word." << std::endl;
             continue;
         }
         
+        // One snapshot for the whole answer, so a reload cannot free the suggestions being shown
+        std::shared_ptr<const DictionarySnapshot> dictionary = spellChecker.snapshot();
+        
+        // "pre*" lists the most common words starting with "pre"
+        if (userInput.size() > 1 && userInput.back() == '*') {
+            std::string_view prefix = std::string_view(userInput).substr(0, userInput.size() - 1);
+            displaySuggestions(dictionary->getCompletions(prefix, SUGGESTION_LIMIT), dictionary->countCompletions(prefix));
+            std::cout << std::endl;
+            continue;
+        }
+        
         // Case 1: Word exists in dictionary
-        if (spellChecker.wordExists(userInput)) {
+        if (dictionary->wordExists(userInput)) {
             std::cout << "True" << std::endl;
             
             // Get and display suggestions
-            std::vector<std::string> suggestions = spellChecker.getSuggestions(userInput);
-            displaySuggestions(suggestions);
+            std::vector<std::string_view> suggestions = dictionary->getSuggestions(userInput, SUGGESTION_LIMIT);
+            displaySuggestions(suggestions, dictionary->countSuggestions(userInput));
         }
         // Case 2: Word doesn't exist but might be a misspelling
         else {
-            std::string similarWord = spellChecker.findSimilarWord(userInput);
+            std::string similarWord = dictionary->findSimilarWord(userInput);
             
             if (!similarWord.empty()) {
                 std::string response = getInput("Do you mean '" + similarWord + "'? (yes/no): ");
@@ -233,8 +2805,8 @@ int main() {
                 if (response == "yes" || response == "y") {
                     std::cout << "True" << std::endl;
                     // Show suggestions for the corrected word
-                    std::vector<std::string> suggestions = spellChecker.getSuggestions(similarWord);
-                    displaySuggestions(suggestions);
+                    std::vector<std::string_view> suggestions = dictionary->getSuggestions(similarWord, SUGGESTION_LIMIT);
+                    displaySuggestions(suggestions, dictionary->countSuggestions(similarWord));
                 } else {
                     std::cout << "False" << std::endl;
                 }
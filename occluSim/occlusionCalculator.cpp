@@ -5,6 +5,11 @@
 #include <random>
 #include <chrono>
 #include <iomanip>
+#include <string>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <cstdlib>
 #include <locale>
 #include <codecvt>
 
@@ -50,109 +55,300 @@ Rectangle generateRandomRectangle(mt19937& gen, int n) {
     return Rectangle(center, width, height, rotation, distance);
 }
 
-// Calculate interval for a rectangle
-pair<double, double> getRectangleAngularInterval(const Rectangle& rect) {
-    vector<Point> vertices;
-    
-    // Calculate rectangle vertices
-    double half_w = rect.width / 2.0;
-    double half_h = rect.height / 2.0;
-    
-    vector<Point> local_vertices = {
-        Point(-half_w, -half_h),
-        Point(half_w, -half_h),
-        Point(half_w, half_h),
-        Point(-half_w, half_h)
-    };
-    
-    //Transform vertices to coordinates
-    for (const auto& vertex : local_vertices) {
-        //Rotate
-        double x_rot = vertex.x * cos(rect.rotation) - vertex.y * sin(rect.rotation);
-        double y_rot = vertex.x * sin(rect.rotation) + vertex.y * cos(rect.rotation);
+// Rectangles stored field by field (structure of arrays) so the interval kernel
+// can load the same field of several rectangles with one vector instruction.
+// The rotation is kept as its cosine and sine, computed once when the rectangle is added.
+template <typename Real>
+struct RectangleBatch {
+    vector<Real> center_x, center_y;
+    vector<Real> half_width, half_height;
+    vector<Real> cos_rotation, sin_rotation;
+    
+    void reserve(size_t n) {
+        center_x.reserve(n);
+        center_y.reserve(n);
+        half_width.reserve(n);
+        half_height.reserve(n);
+        cos_rotation.reserve(n);
+        sin_rotation.reserve(n);
+    }
+    
+    void push_back(const Rectangle& rect) {
+        center_x.push_back(static_cast<Real>(rect.center.x));
+        center_y.push_back(static_cast<Real>(rect.center.y));
+        half_width.push_back(static_cast<Real>(rect.width / 2.0));
+        half_height.push_back(static_cast<Real>(rect.height / 2.0));
+        cos_rotation.push_back(static_cast<Real>(cos(rect.rotation)));
+        sin_rotation.push_back(static_cast<Real>(sin(rect.rotation)));
+    }
+    
+    size_t size() const { return center_x.size(); }
+};
+
+// Stand-in for the polar angle that needs one division and no trigonometry: it rises
+// from 0 to 4 as the angle goes from 0 to 2pi (one unit per quadrant), so it orders
+// directions exactly like their angles do. pseudoAngleToRadians converts back.
+// Built from arithmetic and copysign only, so it vectorizes.
+template <typename Real>
+inline Real pseudoAngle(Real x, Real y) {
+    Real ax = fabs(x), ay = fabs(y);
+    Real q = ay / max(ax + ay, numeric_limits<Real>::min());  // 0 on the x axis, 1 on the y axis
+    Real upper = 1 + copysign(Real(1), x) * (q - 1);              // [0, 2] in the upper half-plane
+    return 2 + copysign(Real(1), y + Real(0)) * (upper - 2);      // + 0 turns -0 into +0, as atan2 keeps it at 0
+}
+
+// Polar angle (0 to 2pi) of a pseudo-angle
+double pseudoAngleToRadians(double p) {
+    double quadrant = floor(p);
+    double f = p - quadrant;
+    return quadrant * (PI / 2) + cartesianToAngle(1 - f, f);
+}
+
+// Moves (sx, sy) to (x, y) if that is clockwise of it, and (ex, ey) if counterclockwise
+template <typename Real>
+inline void keepExtremeCorners(Real x, Real y, Real& sx, Real& sy, Real& ex, Real& ey) {
+    bool clockwise = sx * y - sy * x < 0;
+    bool counterclockwise = ex * y - ey * x > 0;
+    sx = clockwise ? x : sx;
+    sy = clockwise ? y : sy;
+    ex = counterclockwise ? x : ex;
+    ey = counterclockwise ? y : ey;
+}
+
+// Angular interval of rectangles begin to end-1 as pseudo-angles, running
+// counterclockwise from starts[i] to ends[i]. starts[i] > ends[i] means the
+// interval crosses angle 0; a rectangle containing the origin gets [0, 4].
+// The bounding corners are found with cross products: a rectangle that does not
+// contain the origin spans less than pi, so "clockwise of" orders its corners
+// exactly like their angles, and only those two corners are converted.
+// No allocation and no branches, so the loop vectorizes: 4 doubles or 8 floats per
+// instruction with AVX2 (/O2 /arch:AVX2, -O3 -mavx2), 8 or 16 with AVX-512. The arrays are
+// marked __restrict: with eight of them, checking overlaps at run time is too many
+// checks and the compiler gives up on vectorizing instead.
+template <typename Real>
+void getAngularIntervals(const RectangleBatch<Real>& rects, size_t begin, size_t end,
+                         Real* __restrict starts, Real* __restrict ends) {
+    const Real* __restrict cx = rects.center_x.data();
+    const Real* __restrict cy = rects.center_y.data();
+    const Real* __restrict hw = rects.half_width.data();
+    const Real* __restrict hh = rects.half_height.data();
+    const Real* __restrict cr = rects.cos_rotation.data();
+    const Real* __restrict sr = rects.sin_rotation.data();
+    
+    for (size_t i = begin; i < end; i++) {
+        //Half-extent vectors along the rotated width and height
+        Real wx = hw[i] * cr[i], wy = hw[i] * sr[i];
+        Real hx = -hh[i] * sr[i], hy = hh[i] * cr[i];
+        
+        //Vertices (-w,-h), (w,-h), (w,h), (-w,h) around the center
+        Real sx = cx[i] - wx - hx, sy = cy[i] - wy - hy;
+        Real ex = sx, ey = sy;
+        keepExtremeCorners(cx[i] + wx - hx, cy[i] + wy - hy, sx, sy, ex, ey);
+        keepExtremeCorners(cx[i] + wx + hx, cy[i] + wy + hy, sx, sy, ex, ey);
+        keepExtremeCorners(cx[i] - wx + hx, cy[i] - wy + hy, sx, sy, ex, ey);
         
-        //Translate
-        double x_global = rect.center.x + x_rot;
-        double y_global = rect.center.y + y_rot;
+        //The origin is covered (or touched) when it lies within the half extents in the rectangle's own frame
+        Real local_x = -(cx[i] * cr[i] + cy[i] * sr[i]);
+        Real local_y = cx[i] * sr[i] - cy[i] * cr[i];
+        bool surrounds = (fabs(local_x) <= hw[i]) & (fabs(local_y) <= hh[i]);
         
-        vertices.emplace_back(x_global, y_global);
+        //Clamped rather than selected, so no arithmetic ends up inside a branch
+        starts[i] = min(pseudoAngle(sx, sy), surrounds ? Real(0) : Real(4));
+        ends[i] = max(pseudoAngle(ex, ey), surrounds ? Real(4) : Real(0));
+    }
+}
+
+// Runs fn(t) for t = 0..threads-1 on separate threads and waits for all of them
+template <typename Fn>
+void parallelFor(int threads, Fn fn) {
+    vector<thread> workers;
+    for (int t = 1; t < threads; t++) {
+        workers.emplace_back(fn, t);
+    }
+    fn(0);
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+const int DIGIT_BITS = 10;
+const size_t DIGIT_COUNT = size_t(1) << DIGIT_BITS;
+
+// Pseudo-angle in [0, 4] quantized to two radix digits, in angle order
+inline size_t angleKey(double p) {
+    return min(DIGIT_COUNT * DIGIT_COUNT - 1, static_cast<size_t>(p * (DIGIT_COUNT * DIGIT_COUNT / 4)));
+}
+
+bool startsBefore(const pair<double, double>& a, const pair<double, double>& b) {
+    return a.first < b.first;
+}
+
+// Sorts intervals[begin, end), which all share their first key digit, by start: a
+// counting pass on the second digit (in cache, since a bucket is small), then an
+// exact sort of each sub-bucket, which holds a handful of intervals
+void sortBucket(vector<pair<double, double>>& intervals, size_t begin, size_t end,
+                vector<pair<double, double>>& scratch, vector<size_t>& next) {
+    if (end - begin < 2) return;
+    next.assign(DIGIT_COUNT + 1, 0);
+    for (size_t i = begin; i < end; i++) {
+        next[(angleKey(intervals[i].first) & (DIGIT_COUNT - 1)) + 1]++;
+    }
+    for (size_t d = 1; d <= DIGIT_COUNT; d++) {
+        next[d] += next[d - 1];
+    }
+    scratch.resize(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        scratch[next[angleKey(intervals[i].first) & (DIGIT_COUNT - 1)]++] = intervals[i];
     }
     
-    //Calculate angles for all vertices
-    vector<double> angles;
-    for (const auto& vertex : vertices) {
-        angles.push_back(cartesianToAngle(vertex.x, vertex.y));
+    //next[d] is now where sub-bucket d ends
+    size_t sub_begin = 0;
+    for (size_t d = 0; d < DIGIT_COUNT; d++) {
+        size_t sub_end = next[d];
+        if (sub_end - sub_begin > 32) {
+            sort(scratch.begin() + sub_begin, scratch.begin() + sub_end, startsBefore);
+        } else {
+            for (size_t i = sub_begin + 1; i < sub_end; i++) {
+                pair<double, double> value = scratch[i];
+                size_t j = i;
+                for (; j > sub_begin && value.first < scratch[j - 1].first; j--) scratch[j] = scratch[j - 1];
+                scratch[j] = value;
+            }
+        }
+        sub_begin = sub_end;
     }
+    copy(scratch.begin(), scratch.end(), intervals.begin() + begin);
+}
+
+// Pieces of an interval: itself, or [start, 4) and [0, end) if it crosses angle 0
+template <typename Real, typename Fn>
+inline void forEachPiece(Real start, Real end, Fn fn) {
+    if (start <= end) {
+        fn(static_cast<double>(start), static_cast<double>(end));
+    } else {
+        fn(static_cast<double>(start), 4.0);
+        fn(0.0, static_cast<double>(end));
+    }
+}
+
+// Intervals of all rectangles as pseudo-angle pairs, sorted by start. Each thread
+// computes the intervals of its share of the rectangles and counts their pieces by
+// the first digit of their quantized start angle; one radix pass then scatters
+// every piece straight into bucket order, and the buckets are sorted in parallel.
+template <typename Real>
+vector<pair<double, double>> sortedIntervals(const RectangleBatch<Real>& rects, int threads) {
+    const size_t n = rects.size();
+    vector<Real> starts(n), ends(n);
+    vector<vector<size_t>> counts(threads, vector<size_t>(DIGIT_COUNT, 0));
     
-    //Find min and max
-    double min_angle = *min_element(angles.begin(), angles.end());
-    double max_angle = *max_element(angles.begin(), angles.end());
+    //Generate and count
+    parallelFor(threads, [&](int t) {
+        size_t begin = n * t / threads, end = n * (t + 1) / threads;
+        getAngularIntervals(rects, begin, end, starts.data(), ends.data());
+        vector<size_t>& count = counts[t];
+        for (size_t i = begin; i < end; i++) {
+            forEachPiece(starts[i], ends[i], [&](double start, double) { count[angleKey(start) >> DIGIT_BITS]++; });
+        }
+    });
     
-    //Handle wrap-around
-    if (max_angle - min_angle > PI) {
-        //If rectangle spans more than 180 degrees, handles carefully
-        return make_pair(0.0, TWO_PI);
+    //Turn the counts into where each thread writes each bucket
+    vector<size_t> bucket_begin(DIGIT_COUNT + 1);
+    size_t total = 0;
+    for (size_t b = 0; b < DIGIT_COUNT; b++) {
+        bucket_begin[b] = total;
+        for (int t = 0; t < threads; t++) {
+            size_t count = counts[t][b];
+            counts[t][b] = total;
+            total += count;
+        }
     }
+    bucket_begin[DIGIT_COUNT] = total;
+    
+    //Scatter
+    vector<pair<double, double>> intervals(total);
+    parallelFor(threads, [&](int t) {
+        size_t begin = n * t / threads, end = n * (t + 1) / threads;
+        vector<size_t>& next = counts[t];
+        for (size_t i = begin; i < end; i++) {
+            forEachPiece(starts[i], ends[i], [&](double start, double finish) {
+                intervals[next[angleKey(start) >> DIGIT_BITS]++] = make_pair(start, finish);
+            });
+        }
+    });
     
-    return make_pair(min_angle, max_angle);
+    //Sort the buckets, handing them out one at a time
+    atomic<size_t> next_bucket(0);
+    parallelFor(threads, [&](int) {
+        vector<pair<double, double>> scratch;
+        vector<size_t> next;
+        for (size_t b = next_bucket++; b < DIGIT_COUNT; b = next_bucket++) {
+            sortBucket(intervals, bucket_begin[b], bucket_begin[b + 1], scratch, next);
+        }
+    });
+    return intervals;
 }
 
-//Merge overlapping intervals and calculate total coverage
-double mergeIntervals(vector<pair<double, double>>& intervals) {
-    if (intervals.empty()) return 0.0;
+// Length in radians of the union of pseudo-angle intervals sorted by start, without
+// building the merged list: a merged run begins wherever an interval starts beyond the
+// furthest end reached so far, and the coverage is the sum of (run end - run start).
+// Chunks are scanned in parallel; each only needs the furthest end reached before it,
+// which is the largest end of the chunks in front of it.
+double totalCoverage(const vector<pair<double, double>>& intervals, int threads) {
+    const size_t n = intervals.size();
+    if (n == 0) return 0.0;
     
-    //Sort intervals by start angle
-    sort(intervals.begin(), intervals.end());
+    vector<double> chunk_reach(threads, -1.0);
+    parallelFor(threads, [&](int t) {
+        double reach = -1.0;
+        for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+            reach = max(reach, intervals[i].second);
+        }
+        chunk_reach[t] = reach;
+    });
     
-    vector<pair<double, double>> merged;
-    merged.push_back(intervals[0]);
+    //Stitch: furthest end before each chunk
+    vector<double> reach_before(threads, -1.0);
+    for (int t = 1; t < threads; t++) {
+        reach_before[t] = max(reach_before[t - 1], chunk_reach[t - 1]);
+    }
     
-    for (size_t i = 1; i < intervals.size(); i++) {
-        auto& current = intervals[i];
-        auto& last = merged.back();
-        
-        if (current.first <= last.second) {
-            // Intervals overlap, merge them
-            last.second = max(last.second, current.second);
-        } else {
-            // No overlap, add new interval
-            merged.push_back(current);
+    vector<double> partial(threads, 0.0);
+    parallelFor(threads, [&](int t) {
+        double reach = reach_before[t];
+        double coverage = 0.0;
+        for (size_t i = n * t / threads; i < n * (t + 1) / threads; i++) {
+            if (intervals[i].first > reach) {
+                //The previous run ended at reach, a new one starts here
+                if (reach >= 0.0) coverage += pseudoAngleToRadians(reach);
+                coverage -= pseudoAngleToRadians(intervals[i].first);
+            }
+            reach = max(reach, intervals[i].second);
         }
-    }
+        partial[t] = coverage;
+    });
     
-    // Calculate total coverage
-    double total_coverage = 0.0;
-    for (const auto& interval : merged) {
-        total_coverage += interval.second - interval.first;
+    double total_coverage = pseudoAngleToRadians(max(reach_before[threads - 1], chunk_reach[threads - 1]));
+    for (double coverage : partial) {
+        total_coverage += coverage;
     }
-    
     return total_coverage;
 }
 
-int main() {
-    int n;
-    cout << "Enter number of rectangles (n): ";
-    cin >> n;
-    
-    //random number generator
-    unsigned seed = chrono::system_clock::now().time_since_epoch().count();
-    mt19937 gen(seed);
-    
+// Generates n rectangles, computes their intervals in Real precision and prints the results
+template <typename Real>
+void runOcclusion(int n, int threads, mt19937& gen) {
     //Generate random rectangles
-    vector<Rectangle> rectangles;
+    RectangleBatch<Real> rectangles;
+    rectangles.reserve(n);
     for (int i = 0; i < n; i++) {
         rectangles.push_back(generateRandomRectangle(gen, n));
     }
     
-    //Calculate angular intervals for all rectangles
-    vector<pair<double, double>> intervals;
-    for (const auto& rect : rectangles) {
-        auto interval = getRectangleAngularInterval(rect);
-        intervals.push_back(interval);
-    }
-    
-    // Merge intervals and calculate total visible angle
-    double total_visible_rad = mergeIntervals(intervals);
+    //Calculate, sort and merge the angular intervals
+    auto pipeline_start = chrono::steady_clock::now();
+    vector<pair<double, double>> intervals = sortedIntervals(rectangles, threads);
+    double total_visible_rad = totalCoverage(intervals, threads);
+    double pipeline_seconds = chrono::duration<double>(chrono::steady_clock::now() - pipeline_start).count();
     double total_visible_deg = total_visible_rad * 180.0 / PI;
     
     // Calculate occlusion angle (what's NOT visible)
@@ -166,6 +362,48 @@ int main() {
     cout << "Number of rectangles: " << n << endl;
     cout << "Total visible angle: " << fixed << setprecision(2) << total_visible_deg << " degrees" << endl;
     cout << "Occlusion angle: " << fixed << setprecision(2) << occlusion_angle << " degrees" << endl;
+    cout << "Intervals computed, sorted and merged in " << setprecision(4) << pipeline_seconds * 1000.0 << " ms ("
+         << setprecision(1) << n / max(pipeline_seconds, 1e-9) / 1e6 << " million rectangles/s, "
+         << (sizeof(Real) == sizeof(float) ? "float" : "double") << ", " << threads << " threads)" << endl;
+}
+
+// occlusionCalculator.exe --float: compute the intervals in single precision (twice the SIMD width)
+// occlusionCalculator.exe --threads 8: number of threads (default: one per core)
+int main(int argc, char* argv[]) {
+    bool use_float = false;
+    int cores = max(1u, thread::hardware_concurrency());
+    long requested = cores;
+    for (int i = 1; i < argc; i++) {
+        if (string(argv[i]) == "--float") {
+            use_float = true;
+        } else if (string(argv[i]) == "--threads" && i + 1 < argc) {
+            char* end = nullptr;
+            requested = strtol(argv[++i], &end, 10);
+            if (end == argv[i] || *end != '\0' || requested < 1) {
+                cout << "Error: --threads needs a positive whole number, got '" << argv[i] << "'" << endl;
+                return 1;
+            }
+        }
+    }
+    
+    int n;
+    cout << "Enter number of rectangles (n): ";
+    cin >> n;
+    n = max(n, 0);
+    
+    //Every thread gets its own counters and at least one rectangle; oversubscribing
+    //the cores more than 4x only adds thread start-up and counter memory
+    int threads = static_cast<int>(min<long>(requested, min(max(1, n), 4 * cores)));
+    
+    //random number generator
+    unsigned seed = chrono::system_clock::now().time_since_epoch().count();
+    mt19937 gen(seed);
+    
+    if (use_float) {
+        runOcclusion<float>(n, threads, gen);
+    } else {
+        runOcclusion<double>(n, threads, gen);
+    }
     
     return 0;
-}
\ No newline at end of file
+}
@@ -60,11 +60,12 @@ int main() {
         };
 
         //Rotate corners
+        double cosR = cos(r.rotation), sinR = sin(r.rotation);
         for (auto &c : corners) {
             double dx = c.first - r.x;
             double dy = c.second - r.y;
-            double newx = r.x + dx * cos(r.rotation) - dy * sin(r.rotation);
-            double newy = r.y + dx * sin(r.rotation) + dy * cos(r.rotation);
+            double newx = r.x + dx * cosR - dy * sinR;
+            double newy = r.y + dx * sinR + dy * cosR;
             c.first = newx;
             c.second = newy;
         }
@@ -77,16 +78,32 @@ int main() {
         std::cout << std::endl;
 
 
-        //angles of corners
-        double minAngle = 1e9, maxAngle = -1e9;
+        //a rectangle on top of the origin blocks every direction
+        double localX = -(r.x * cosR + r.y * sinR);
+        double localY = r.x * sinR - r.y * cosR;
+        if (std::fabs(localX) <= hw && std::fabs(localY) <= hh) {
+            intervals.push_back({0, 360});
+            continue;
+        }
+
+        //first and last corner going counterclockwise, by cross product sign:
+        //the rectangle spans less than 180 degrees, so this orders the corners
+        //like their angles and only those two need atan2
+        std::pair<double,double> first = corners[0], last = corners[0];
         for (auto &c : corners) {
-            double angle = atan2(c.second, c.first) * 180.0 / M_PI;
-            angle = normalize(angle);
-            minAngle = std::min(minAngle, angle);
-            maxAngle = std::max(maxAngle, angle);
+            if (first.first * c.second - first.second * c.first < 0) first = c;
+            if (last.first * c.second - last.second * c.first > 0) last = c;
         }
+        double startAngle = normalize(atan2(first.second, first.first) * 180.0 / M_PI);
+        double endAngle = normalize(atan2(last.second, last.first) * 180.0 / M_PI);
 
-        intervals.push_back({minAngle, maxAngle});
+        //an interval crossing 0 degrees is split in two
+        if (startAngle <= endAngle) {
+            intervals.push_back({startAngle, endAngle});
+        } else {
+            intervals.push_back({startAngle, 360});
+            intervals.push_back({0, endAngle});
+        }
     }
 
     //sort + merge intervals